@@ -0,0 +1,123 @@
+#!/bin/bash
+#
+# (c) 2026, Roberto A. Foglietta <roberto.foglietta@gmail.com>, MIT license
+#
+# usage: ucbench.sh [out.json] [baseline.json]
+#
+# runs the option matrix below with each uchaos build found, REPS times on
+# the pinned CPU, and writes the medians as JSON: one result for each line,
+# thus also grep-able. With a baseline, a KH/s or MB/s below it by more than
+# TOL percent is a regression: listed, and the exit code is 1.
+#
+# env: BINS (uchaos uchaos64 uchaos32), REPS (5), CPU (0), TOL (10), KB (1024)
+#      INPUT (dmesg.txt, else uchaos.c)
+#
+
+out=${1:-bench.json}
+base=${2:-}
+bins=${BINS:-uchaos uchaos64 uchaos32}
+reps=${REPS:-5}
+cpu=${CPU:-0}
+tol=${TOL:-10}
+kb=${KB:-1024}
+inp=${INPUT:-dmesg.txt}
+test -r "$inp" || inp=uchaos.c
+
+# name|options, the size and -E are added to all of them, and -i16 before
+# them: uchaos prints the Latency line, thus the ex%, only with 2+ blocks
+matrix=(
+  "default|"
+  "S|-S"
+  "Z|-Z"
+  "r32d3p0|-r32 -d3 -p0"
+  "r32d1p1|-r32 -d1 -p1"
+  "r10d3i16|-r10 -d3 -i16"
+  "s1d3|-s1 -d3"
+  "l4|-l4"
+)
+
+pin=""
+if command -v taskset >/dev/null && taskset -c $cpu true 2>/dev/null; then
+  pin="taskset -c $cpu"
+else
+  echo "WARNING: taskset on CPU $cpu is not available, running unpinned" >&2
+fi
+
+# median of the numbers on stdin
+median() { sort -g | awk '{ v[NR] = $1 } END { if(NR) print v[int((NR+1)/2)]; else print 0 }'; }
+
+# one run: "KH/s MB/s ex% entropy" from the uchaos stats
+onerun() {
+  cat $inp | $pin ./$1 -i16 $2 -E -K $kb 2>&1 >/dev/null | awk '
+    /^Perform:/ { for(i = 1; i <= NF; i++) {
+                    if($i ~ /^MB\/s/ && mbs == "") mbs = $(i-1);
+                    if($i ~ /^KH\/s/) khs = $(i-1) } }
+    /^Latency:/ { if(match($0, /ex: *[0-9.]+/))
+                    ex = substr($0, RSTART + 3, RLENGTH - 3) }
+    /^Entropy:/ { ent = $2 }
+    END { printf "%s %s %s %s\n", khs+0, mbs+0, ex+0, ent+0 }'
+}
+
+res=()
+for b in $bins; do
+  if [ ! -x "./$b" ]; then
+    echo "WARNING: ./$b is not executable, skipped" >&2
+    continue
+  fi
+  bits=$(./$b -v 2>&1 | grep -o "uChaos[0-9]*" | head -1 | tr -dc 0-9)
+  for m in "${matrix[@]}"; do
+    nm=${m%%|*}; op=${m#*|}
+    tmp=$(for r in $(seq $reps); do onerun $b "$op"; done)
+    khs=$(echo "$tmp" | cut -d' ' -f1 | median)
+    mbs=$(echo "$tmp" | cut -d' ' -f2 | median)
+    exr=$(echo "$tmp" | cut -d' ' -f3 | median)
+    ent=$(echo "$tmp" | cut -d' ' -f4 | median)
+    printf "%-9s %3s %-9s %10s KH/s %8s MB/s ex %6s%% ent %s\n" \
+      $b $bits $nm $khs $mbs $exr $ent >&2
+    res+=("$(printf '{"bin": "%s", "bits": %s, "name": "%s", "opts": "%s",'\
+' "khs": %s, "mbs": %s, "exr": %s, "ent": %s}' \
+      "$b" "$bits" "$nm" "$op" "$khs" "$mbs" "$exr" "$ent")")
+  done
+done
+
+{
+  printf '{"version": "%s", "date": "%s", "host": "%s",\n' \
+    "$(./uchaos -v 2>&1 | awk '{ print $2 }')" "$(date +%FT%T%z)" "$(uname -nm)"
+  printf '"cpu": "%s", "pinned": %s, "reps": %s, "kb": %s, "input": "%s",\n' \
+    "$(grep -m1 '^model name' /proc/cpuinfo 2>/dev/null | cut -d: -f2- | \
+      sed 's/^[ \t]*//')" "$([ -n "$pin" ] && echo $cpu || echo null)" \
+    $reps $kb $inp
+  echo '"results": ['
+  for ((i = 0; i < ${#res[@]}; i++)); do
+    printf '%s%s\n' "${res[$i]}" "$([ $i -lt $((${#res[@]} - 1)) ] && echo ,)"
+  done
+  echo ']}'
+} > $out
+echo "ucbench.sh wrote: $out" >&2
+
+test -n "$base" || exit 0
+if [ ! -r "$base" ]; then
+  echo "ERROR: baseline $base is not readable" >&2
+  exit 1
+fi
+
+# field $2 of the JSON line $1
+jval() { echo "$1" | sed -ne "s/.*\"$2\": \"*\([^,\"}]*\).*/\1/p"; }
+
+nrg=0
+for r in "${res[@]}"; do
+  key=$(echo "$r" | sed -e 's/, "opts".*//')
+  old=$(grep -F "$key," $base | head -1)
+  test -n "$old" || continue
+  for f in khs mbs; do
+    o=$(jval "$old" $f); n=$(jval "$r" $f)
+    if awk -v o=$o -v n=$n -v t=$tol 'BEGIN { exit !(n < o * (100 - t) / 100) }'
+    then
+      printf "REGRESSION: %s %s %s, %s: %s -> %s\n" $(jval "$r" bin) \
+        $(jval "$r" bits) $(jval "$r" name) $f $o $n >&2
+      nrg=$((nrg + 1))
+    fi
+  done
+done
+printf "Baseline: %s, %d regression(s) over %s%% of tolerance\n" $base $nrg $tol >&2
+test $nrg -eq 0
@@ -5,11 +5,16 @@
 /* Quick 2k test: cat uchaos.c  | ./chaos -T 2048 | ent
  * Boot log test: cat dmesg.txt | ./uchaos -S -M2 | ent
  *
- * Compile w/libc:      gcc uchaos.c -O3 --fast-math -Wall -o uchaos -s -lm
+ * Compile w/libc:      gcc uchaos.c -O3 --fast-math -Wall -o uchaos -s -lm -lpthread
  * Compile 4speed:                   -mavx2 -march=native -funroll-loops
+ *                 (or none of them: the hot loop is dispatched by CPUID)
  * Compile w/musl: musl-gcc uchaos.c -O3 --fast-math -Wall -o uchaos -s -static
- * Compile option: -D_USE_GET_RTSC (i686: -m32 -msse2), -D_USE_LINUX_RANDOM_H
+ * Compile option: -D_USE_GET_RTSC (TSC by default, i686: -m32 -msse2)
+ *                 -D_USE_LINUX_RANDOM_H
  *                 -D_USE_FUNCS_32 (i686: -m32, native), -D_USE_PREV_TIME
+ *                 -D_USE_PROFILING (hot loop stages, a table at the exit)
+ *                 -D_USE_TINY (static arenas, no malloc/stdio/libm, -h)
+ * Compile as lib: gcc uchaos.c -O3 -c -D_UCHAOS_LIB (no main, see uchaos.h)
  * Test with: ent, dieharder, PractRand RNG_test (compiled for Ubuntu 22.04 x64)
  *      drive.google.com/file/d/17ymBcxfO2pA8ET7T4ZxiiO2EYW6_F8Lu/view
  * Qemu test: cd bare-minimal-linux-system; sh start.sh "" bzImage.515x
@@ -37,7 +42,8 @@
  *
  * Note: current implementation is a text strings-only PoC, it cannot deal with
  * binary input that has EOB char (\0) in the input data. Quick to change but it
- * is not the point here but djb2tum, possibly.
+ * is not the point here but djb2tum, possibly. Except the -C conditioner mode,
+ * which is binary safe and consumes an endless stream (e.g. /dev/urandom).
  *
  * While uchaos.c has been developed as early source for /dev/random leveraging
  * dmesg timings in the boot log, it can works with a simple adaptation (text
@@ -104,8 +110,6 @@
  *
  * TODO LIST
  *
- * Before and after writing in the /dev/random, read avail. entropy from proc
- *
  * Create a set of "bit of entropy per byte" polices, and use #if to compile:
  *   - optimistic 7hw 3vm; or flipcoin 4hw 2vm; or minimal 2hw 1vm.
  *
@@ -122,11 +126,25 @@
 #include <stddef.h>
 #include <time.h>
 #include <math.h>
+#if defined(__x86_64__) || defined(__i386__)
 #include <immintrin.h>
+#endif
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/syscall.h>
+#include <getopt.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #define AVGV 127.5
 #define E3 1000
@@ -141,6 +159,20 @@
 #define BIT(v,n)  ( ( (v) >> (n) ) & 1 )
 #define perr(x...) fprintf(stderr, x)
 
+#ifdef _USE_TINY
+// no stdio: perror() by a single write(2), the errno as a decimal number
+static void __attribute__((unused)) tinyerr(const char *s) {
+    char b[80], *p = b + sizeof(b);
+    uint32_t e = errno, n = MIN(strlen(s), sizeof(b) - 24);
+    *--p = '\n';
+    do *--p = '0' + e % 10; while(e /= 10);
+    p -= 8; memcpy(p, ": errno ", 8);
+    p -= n; memcpy(p, s, n);
+    (void)!write(STDERR_FILENO, p, b + sizeof(b) - p);
+}
+#define perror(s) tinyerr(s)
+#endif
+
 #if 0 // RAF: this code is not used anymore but remains for educational purpose
       //      functionally is converted into a commentary section about uchaos.c
       //
@@ -153,6 +185,8 @@ static inline uint8_t *bin2s64(uint8_t *buf, uint32_t nmax) {
 }
 #endif
 
+#include "uchaos.h"
+
 #ifdef __x86_64__
 #pragma message("Compiling for the 64-bit arch")
 #define ALGN 128         // host's CPU can have AVX or AVX2 instructions
@@ -161,32 +195,15 @@ static inline uint8_t *bin2s64(uint8_t *buf, uint32_t nmax) {
 #define ALGN  64         // host can be a 64bit machine with pie32 elf
 #endif
 
-#ifdef _USE_FUNCS_32
-#define USE_FUNCS_32 1
-#else
-#define USE_FUNCS_32 0
-#endif
-
 #if USE_FUNCS_32
 #pragma message("Using the 32-bit functions set")
-    typedef float    archdf_t;
-    typedef uint32_t archul_t;
-    #define AB     5     //  5 -> 32
+#define AB     5         //  5 -> 32
+#elif HAS_UINT128
+#pragma message("Using the 128-bit functions set")
+#define AB     7         //  7 -> 64
 #else
-    typedef double   archdf_t;
-    #if defined(__SIZEOF_INT128__)
-    #pragma message("Using the 128-bit functions set")
-        #define HAS_UINT128 1
-        typedef unsigned __int128 uint128_t;
-        typedef uint128_t archul_t;
-        #define AB  7    //  7 -> 64
-    #else
-    #pragma message("Using the 64-bit functions set")
-        #define HAS_UINT128 0
-        typedef uint64_t archul_t;
-        #define AB  6    //  6 -> 64
-    #endif
-
+#pragma message("Using the 64-bit functions set")
+#define AB     6         //  6 -> 64
 #endif
 
 #define ABL (AB-3)       //  2 or  3
@@ -196,8 +213,28 @@ static inline uint8_t *bin2s64(uint8_t *buf, uint32_t nmax) {
 #define ABy ((ABN>>2)-1) //  7 or 15
 #define ABz ((ABN>>3)-1) //  3 or  7
 
-#ifdef _USE_GET_RTSC /* ****************************************************** */
-#define USE_GET_TIME 0
+/*
+ * One of the most popular and efficient hash functions for strings in C is
+ * the djb2 algorithm created by Dan Bernstein. It strikes a great balance
+ * between speed and low collision rates. Great for text.
+ *
+ * 5381              Prime number choosen by Dan Bernstein, as 1010100000101
+ *                   empirically is one of the best for English words text.
+ * Alternatives:
+ *
+ * 16777619               The FNV-1 offset basis (32-bit).
+ * 14695981039346656037	  The FNV-1 offset basis (64-bit).
+ */
+#if USE_FUNCS_32
+#define HSHSEED 16777619
+#else
+#define HSHSEED 14695981039346656037ULL
+#endif
+
+#define djb2tum_status_init { 0,-1,0, 0,-1,0, 0,-1,0, 0,0,0, 0,-1,0, HSHSEED, 0, 1,\
+    { 0 }, { { 0,0, 0,0,0 }, { 0,0, 0,0,0 } }, 0, { 0 }, 0, NULL }
+
+#if defined(__x86_64__) || defined(__i386__) /* ***************************** */
 /*
  * Available only on x86 architecture, thus not portable
  * moreover, when the CPU id changes the two clocks aren't
@@ -211,8 +248,11 @@ static inline uint8_t *bin2s64(uint8_t *buf, uint32_t nmax) {
  * in /init esecution at 0.1s which suggest that TSC isn't suitable, anyway.
  */
 #include <x86intrin.h>
+#include <cpuid.h>
 #ifndef __SSE2__
+#ifdef _USE_GET_RTSC
 #warning "SSE2 not detected (-msse2). Falling back to skew risky CPUID fence."
+#endif
 static inline uint32_t __cpuid__slfence(void) {
     uint32_t eax, ebx, ecx, edx;             // cpuid is a heavy-duty serializer
     __asm__ __volatile__ ("cpuid" : "=a"(eax), "=b"(ebx),
@@ -221,21 +261,46 @@ static inline uint32_t __cpuid__slfence(void) {
     return (ebx >> 24);
 }
 #endif
-static inline uint32_t get_rdtsc_clock(uint32_t *pcpuid) {
+static inline uint64_t get_rdtsc_clock(uint32_t *pcpuid) {
+    uint32_t cpuid;
     __asm__ __volatile__ ("" ::: "memory");  // Compiler barrier: avoid reording
 #ifdef __SSE2__
-    _mm_lfence(); return __rdtscp(pcpuid);
+    _mm_lfence(); uint64_t tsc = __rdtscp(&cpuid);
 #else
-#warning "Instruction __rdtscp() not available. Falling back to __asm__ rdtsc."
     uint32_t lsb, msb;
-    *pcpuid = __cpuid__slfence();
+    cpuid = __cpuid__slfence();
     // non-atomic: scheduler can switch CPU here, it needs sched_setaffinity()
     __asm__ __volatile__ ("rdtsc" : "=a" (lsb), "=d" (msb));
-    return lsb;
+    uint64_t tsc = ((uint64_t)msb << 32) | lsb;
 #endif
+    if(pcpuid) *pcpuid = cpuid;
+    return tsc;
 }
-#else /* ******************************************************************** */
-#define USE_GET_TIME 1
+// RDTSCP and the invariant TSC (constant rate, not stopped in C-states)
+static inline bool get_rdtsc_check(void) {
+    uint32_t eax, ebx, ecx, edx;
+    if(!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007)
+        return 0;
+    __get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx);
+    if(!(edx & (1 << 27))) return 0;
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return !!(edx & (1 << 8));
+}
+#define HAS_RDTSC 1
+#else
+#define HAS_RDTSC 0
+#endif /* ******************************************************************* */
+
+#if defined(__aarch64__) /* ************************************************* */
+// The virtual counter is the one the vDSO reads, but without its overhead
+static inline uint64_t get_cntvct_clock(uint32_t *pcpuid) {
+    uint64_t cnt;
+    __asm__ __volatile__ ("isb; mrs %0, cntvct_el0" : "=r" (cnt) :: "memory");
+    return cnt;
+}
+#define HAS_CNTVCT 1
+#else
+#define HAS_CNTVCT 0
 #endif /* ******************************************************************* */
 
 #if 0 // RAF: this code is not used anymore but remains for educational purpose
@@ -274,6 +339,16 @@ static inline archul_t rotlbit(archul_t n, uint8_t c) {
     c &= ABX; return (n << c) | (n >> ((-c) & ABX));
 }
 
+static inline uint32_t popcnt(archul_t w) {
+#if USE_FUNCS_32
+    return __builtin_popcount(w);
+#elif HAS_UINT128
+    return __builtin_popcountll((uint64_t)w) + __builtin_popcountll(w >> 64);
+#else
+    return __builtin_popcountll(w);
+#endif
+}
+
 #define BLOCK_SIZE 512
 
 #ifdef _USE_LINUX_RANDOM_H
@@ -294,18 +369,134 @@ struct rand_pool_info_buf {
  * it is impose a pragma, and if compiler cannot satisfy it, warning at least.
  */
 
-static inline uint32_t getnstime(uint32_t *pcpuid) {
-#if ! USE_GET_TIME
-    if(pcpuid) return get_rdtsc_clock(pcpuid);
-#endif
-    uint32_t ns;
+/* *** CLOCK SOURCES ******************************************************** */
+/*
+ * The clock is chosen at runtime among the ones available on the host and all
+ * of them return the full 64-bit value: the deltas are always right, thus no
+ * samples are thrown away at the wrap as the 4-seconds 32-bit folding did.
+ * With "auto", each POSIX source is measured for call cost and resolution and
+ * the cheapest among the ones with enough resolution (CLK_MAXRES) is selected.
+ * The counters (tsc, cntv) are only by name: the TSC is not reliable at boot,
+ * see above, and their units are ticks while the POSIX clocks are in ns.
+ * Only the TSC reports the CPU id, which djb2tum uses as an extra event.
+ */
+
+#define CLK_CALIBS 1024              // clock calls to measure each source
+#define CLK_MAXRES 64                // ns, enough to see the jitter
+
+static inline uint64_t getclkns(clockid_t id) {
     struct timespec ts;                  // using sched_yield() to creates chaos,
-    clock_gettime(CLOCK_MONOTONIC, &ts); // getting ns in a hot loop is the limit
+    clock_gettime(id, &ts);              // getting ns in a hot loop is the limit
                                          // and we want to see this limit, in VMs
-    ns  =  ts.tv_nsec;
-    ns += (ts.tv_sec & 1) ?  E9       : 0;
-    ns += (ts.tv_sec & 2) ? (E9 << 1) : 0;
-    return ns;
+    return (uint64_t)ts.tv_sec * E9 + ts.tv_nsec;
+}
+
+static uint64_t clk_mono(uint32_t *pcpuid) { return getclkns(CLOCK_MONOTONIC);     }
+static uint64_t clk_mraw(uint32_t *pcpuid) { return getclkns(CLOCK_MONOTONIC_RAW); }
+static uint64_t clk_boot(uint32_t *pcpuid) { return getclkns(CLOCK_BOOTTIME);      }
+#if HAS_RDTSC
+static uint64_t clk_rtsc(uint32_t *pcpuid) { return get_rdtsc_clock(pcpuid);       }
+#endif
+#if HAS_CNTVCT
+static uint64_t clk_cntv(uint32_t *pcpuid) { return get_cntvct_clock(pcpuid);      }
+#endif
+
+/*
+ * The replay clock is never available to "auto": djb2tum_replay() selects it.
+ * It returns the recorded deltas, or the synthetic ones (a base plus a jitter
+ * by xorshift64), accumulated on a monotonic time: thus the capture can wrap
+ * around and be replayed for as long as it is needed, always in the same way.
+ */
+#define RPL_SYNBASE 100              // ticks of the synthetic deltas
+#define RPL_SYNJIT  0x3F             // mask of their jitter
+
+static djb2rec_t *rplr = NULL;       // capture records, oldest first
+static uint64_t rpln = 0, rpli = 0, rplt = 0, rplx = HSHSEED;
+
+static uint64_t clk_rply(uint32_t *pcpuid) {
+    if(!rplr) {
+        rplx ^= rplx << 13; rplx ^= rplx >> 7; rplx ^= rplx << 17;
+        return rplt += RPL_SYNBASE + (rplx & RPL_SYNJIT);
+    }
+    uint64_t i = rpli++ % rpln;
+    rplt += i ? rplr[i].tm - rplr[i-1].tm : 1;
+    if(pcpuid) *pcpuid = rplr[i].cpuid;
+    return rplt;
+}
+
+typedef struct {
+    const char *name;
+    uint64_t (*func)(uint32_t *pcpuid);
+    bool avail, ns;                  // ns: POSIX clock, the only ones of auto
+    uint32_t cost, res, tpus;        // ns per call, resolution ns, ticks per us
+} clksrc_t;
+
+static clksrc_t clksrcs[] = {
+    { "mono", clk_mono, 1, 1, 0, 0, 0 },
+    { "mraw", clk_mraw, 1, 1, 0, 0, 0 },
+    { "boot", clk_boot, 1, 1, 0, 0, 0 },
+#if HAS_RDTSC
+    { "tsc",  clk_rtsc, 0, 0, 0, 0, 0 },
+#endif
+#if HAS_CNTVCT
+    { "cntv", clk_cntv, 1, 0, 0, 0, 0 },
+#endif
+    { "rply", clk_rply, 0, 0, 0, 1, 1 },
+    { NULL, NULL, 0, 0, 0, 0, 0 }
+};
+
+static clksrc_t *clksrc = &clksrcs[0];
+
+// the unit of the timings, for the reports
+static inline const char *clkunit(void) {
+    return clksrc->ns ? "ns" : "ticks";
+}
+
+static inline uint64_t getnstime(uint32_t *pcpuid) {
+    return clksrc->func(pcpuid);
+}
+
+static void clkcalib(clksrc_t *c) {
+    uint32_t cpuid, i;
+    uint64_t res = -1, t, o, st = c->func(&cpuid), ns = getclkns(CLOCK_MONOTONIC);
+    for(o = st, i = CLK_CALIBS; i; i--, o = t) {
+        t = c->func(&cpuid);
+        if(t > o && t - o < res) res = t - o;
+    }
+    ns = getclkns(CLOCK_MONOTONIC) - ns;
+    c->cost = MAX(1, ns / CLK_CALIBS);
+    c->tpus = MAX(1, (o - st) * E3 / MAX(ns, 1));
+    c->res  = (res == (uint64_t)-1) ? -1 : MAX(1, res * E3 / c->tpus);
+}
+
+int djb2tum_clock(const char *name) {
+    clksrc_t *c, *best = NULL;
+#if HAS_RDTSC
+    for(c = clksrcs; c->name; c++)
+        if(c->func == clk_rtsc) c->avail = get_rdtsc_check();
+#endif
+    for(c = clksrcs; c->name; c++) {
+        if(!c->avail) continue;
+        if(!strcmp(name, "auto")) { if(c->ns) clkcalib(c); }
+        else
+        if(!strcmp(name, c->name)) { clkcalib(c); clksrc = c; return 0; }
+    }
+    if(strcmp(name, "auto")) return -1;
+
+    for(c = clksrcs; c->name; c++) {
+        if(!c->avail || !c->ns || c->res > CLK_MAXRES) continue;
+        if(!best || c->cost < best->cost) best = c;
+    }
+    for(c = clksrcs; !best && c->name; c++) {    // the finest, at least
+        if(!c->avail || !c->ns) continue;
+        if(!best || c->res < best->res) best = c;
+    }
+    if(best) clksrc = best;
+    return 0;
+}
+
+const char *djb2tum_clkname(void) {
+    return clksrc->name;
 }
 
 #if 0 // RAF: this code is not used anymore but remains for educational purpose
@@ -440,10 +631,10 @@ static inline archul_t murmux3(archul_t ks, archul_t p) {
 #endif /* ******************************************************************* */
 
 #define pidx(p) ((uint32_t)(uintptr_t)(p))
-#define perr_app_info(a) { perr("%s%s%u %s%s%s%s%s", (a)?"":"\n", APPNAME, ABN, VERSION,\
-        STBX?" w/sb":"", PRMX?"":" !/pr", USE_GET_TIME?"":" rtcs", (a)?"\n":""); }
+#define perr_app_info(a) { perr("%s%s%u %s%s%s %s %s%s", (a)?"":"\n", APPNAME, ABN,\
+        VERSION, STBX?" w/sb":"", PRMX?"":" !/pr", djb2tum_clkname(),\
+        djb2tum_variant(), (a)?"\n":""); }
 #define PMDLY2NS(x) ( ( ( x * pmdly ) + 127 ) >> 8 )
-#define DJB2VGET ( (archul_t)-1 )
 
 static inline int nsleep(uint32_t ns) {
     struct timespec remaining, request = { 0, ns };
@@ -451,151 +642,609 @@ static inline int nsleep(uint32_t ns) {
     return ret;
 }
 
-typedef struct djb2tum_status {
-    uint64_t  ncl,  dmn,  dmx;
-    uint64_t tncl, tdmn, tdmx;
-    uint64_t ctot,  jmn,  jmx;
-    uint64_t evnt, nexp, javg;
-    uint64_t  avg,  oid, pmns, ohs;
-} __attribute__((aligned(8))) djb2_t;
+#ifndef _USE_TINY
+// the idx-th CPU among the ones this process is allowed to run on, or -1
+static int getcpuidx(uint32_t idx) {
+    cpu_set_t set;
+    if(sched_getaffinity(0, sizeof(set), &set)) return -1;
+    int ncpu = CPU_COUNT(&set);
+    if(ncpu < 1) return -1;
+    idx %= ncpu;
+    for(int c = 0; c < CPU_SETSIZE; c++)
+        if(CPU_ISSET(c, &set) && !idx--) return c;
+    return -1;
+}
+#endif
 
+/* *** JITTER PROBES ******************************************************** */
 /*
- * One of the most popular and efficient hash functions for strings in C is
- * the djb2 algorithm created by Dan Bernstein. It strikes a great balance
- * between speed and low collision rates. Great for text.
- *
- * 5381              Prime number choosen by Dan Bernstein, as 1010100000101
- *                   empirically is one of the best for English words text.
- * Alternatives:
- *
- * 16777619               The FNV-1 offset basis (32-bit).
- * 14695981039346656037	  The FNV-1 offset basis (64-bit).
+ * The perturbation between two clock reads in djb2tum() was sched_yield() only
+ * (cpu_relax() in the kernel driver). A probe is anything that takes a small
+ * but not predictable amount of time, and each host reacts to each of them in
+ * its own way: the --bench-probes mode measures them, -P selects one of them.
+ * The selection is process-wide, the probes' state is thread-local.
  */
-#if USE_FUNCS_32
-#define HSHSEED 16777619
+
+#define JP_PAUSES  64                // PAUSE instructions for each spin
+#define JP_CHASES  32                // dependent loads for each memory walk
+#define JP_LLCSIZE (8 << 20)         // when the LLC size is not available
+
+static inline void jp_yield(void) { sched_yield(); }
+
+static inline void jp_sleep(void) { nsleep(0); }
+
+static inline void jp_none(void) { }   // the replay measures the mixing alone
+
+static void jp_pause(void) {
+    for(register uint32_t i = JP_PAUSES; i; i--) {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#elif defined(__aarch64__)
+        __asm__ __volatile__ ("yield" ::: "memory");
 #else
-#define HSHSEED 14695981039346656037ULL
+        __asm__ __volatile__ ("" ::: "memory");
+#endif
+    }
+}
+
+#ifndef _USE_TINY // chase needs a LLC-sized buffer, futex a peer thread
+// single cycle permutation of cache lines as big as the LLC (Sattolo)
+static uint32_t *jpchain = NULL, jpnlines = 0;
+
+static void jp_chase_init(void) {
+    if(jpchain) return;              // a single chain, by the first call
+    long sz = 0;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    sz = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+    if(sz <= 0) sz = JP_LLCSIZE;
+    uint32_t i, j, n = sz >> 6, x = getnstime(NULL) | 1;
+    if(posix_memalign((void **)&jpchain, 64, (size_t)n << 6) || !jpchain) {
+        jpchain = NULL; return;
+    }
+    for(i = 0; i < n; i++) jpchain[i << 4] = i;
+    for(i = n - 1; i > 0; i--) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;         // xorshift32
+        j = x % i;
+        uint32_t t = jpchain[i << 4];
+        jpchain[i << 4] = jpchain[j << 4]; jpchain[j << 4] = t;
+    }
+    jpnlines = n;
+}
+
+static void jp_chase(void) {
+    static __thread uint32_t c = 0;
+    for(register uint32_t i = JP_CHASES; i; i--)
+        c = ((volatile uint32_t *)jpchain)[c << 4];
+}
+
+// ping-pong with a peer thread pinned on another CPU, futex round-trip
+static void *jp_futex_peer(void *arg) {
+    _Atomic uint32_t *w = (_Atomic uint32_t *)arg;
+    while(1) {
+        while(atomic_load(w) != 1)
+            syscall(SYS_futex, w, FUTEX_WAIT_PRIVATE, 0, NULL, NULL, 0);
+        atomic_store(w, 0);
+        syscall(SYS_futex, w, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+    return NULL;
+}
+
+static void jp_futex(void) {
+    static __thread _Atomic uint32_t *w = NULL;
+    if(!w) {
+        pthread_t tid;
+        pthread_attr_t attr;
+        cpu_set_t set;
+        int cpu = getcpuidx(sched_getcpu() + 1);
+        if(posix_memalign((void **)&w, 64, 64) || !w) { w = NULL; return; }
+        atomic_store(w, 0);
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if(cpu >= 0) {
+            CPU_ZERO(&set); CPU_SET(cpu, &set);
+            pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+        }
+        if(pthread_create(&tid, &attr, jp_futex_peer, (void *)w)) {
+            free((void *)w); w = NULL;
+        }
+        pthread_attr_destroy(&attr);
+        if(!w) return;
+    }
+    atomic_store(w, 1);
+    syscall(SYS_futex, w, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    while(atomic_load(w) != 0)
+        syscall(SYS_futex, w, FUTEX_WAIT_PRIVATE, 1, NULL, NULL, 0);
+}
+#endif
+
+typedef struct {
+    const char *name;
+    void (*func)(void);
+    void (*init)(void);
+} jprobe_t;
+
+static const jprobe_t jprobes[] = {
+    { "yield", jp_yield, NULL },
+    { "sleep", jp_sleep, NULL },
+    { "pause", jp_pause, NULL },
+#ifndef _USE_TINY
+    { "chase", jp_chase, jp_chase_init },
+    { "futex", jp_futex, NULL },
+#endif
+    { "none",  jp_none,  NULL },
+    { NULL, NULL, NULL }
+};
+
+static void (*jprobe)(void) = jp_yield;
+
+int djb2tum_probe(const char *name) {
+    for(const jprobe_t *p = jprobes; p->name; p++) {
+        if(strcmp(name, p->name)) continue;
+        if(p->init) p->init();
+#ifndef _USE_TINY
+        if(p->func == jp_chase && !jpchain) return -1;
+#endif
+        jprobe = p->func;
+        return 0;
+    }
+    return -1;
+}
+
+/* *** RAW CAPTURE ********************************************************** */
+/*
+ * The file is sized and mapped shared with MAP_POPULATE before the run, thus
+ * writing a record is a store in memory which is already paged in: the kernel
+ * writes it back later, without syscalls or page faults in the hot loop. The
+ * format is documented in uchaos.h, the ring keeps the most recent records.
+ * djb2tum_replay() reads a capture back as the clock, for benchmarks and to
+ * check that different builds of the same word size give the same output.
+ */
+
+#ifdef _USE_TINY // no capture: no hook in the hot loop
+int djb2tum_capture(const char *path, uint8_t nbits) {
+    errno = ENOSYS; return -1;
+}
+#else
+static djb2caph_t *caph = NULL;
+static djb2rec_t  *capr = NULL;
+
+int djb2tum_capture(const char *path, uint8_t nbits) {
+    uint64_t nrec = 1ULL << nbits;
+    size_t sz = sizeof(djb2caph_t) + nrec * sizeof(djb2rec_t);
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) return -1;
+    if(ftruncate(fd, sz)) { close(fd); return -1; }
+    void *p = mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        fd, 0);
+    close(fd);
+    if(p == MAP_FAILED) return -1;
+
+    caph = (djb2caph_t *)p;
+    memcpy(caph->magic, CAP_MAGIC, sizeof(caph->magic));
+    caph->version = CAP_VERSION; caph->rsize = sizeof(djb2rec_t);
+    caph->nrec = nrec; caph->head = 0;
+    caph->abn = ABN; caph->tpus = clksrc->tpus;
+    strncpy(caph->clock, clksrc->name, sizeof(caph->clock) - 1);
+    capr = (djb2rec_t *)(caph + 1);
+    return 0;
+}
+#endif
+
+int djb2tum_replay(const char *path) {
+    clksrc_t *c;
+    for(c = clksrcs; c->func != clk_rply; c++);
+    if(strcmp(path, "synth")) {
+        struct stat st;
+        int fd = open(path, O_RDONLY);
+        if(fd < 0) return -1;
+        if(fstat(fd, &st) || st.st_size < (off_t)sizeof(djb2caph_t)) {
+            close(fd); errno = EINVAL; return -1;
+        }
+        void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if(p == MAP_FAILED) return -1;
+
+        const djb2caph_t *h = (const djb2caph_t *)p;
+        const djb2rec_t *r = (const djb2rec_t *)(h + 1);
+        uint64_t n = MIN(h->head, h->nrec), o = (h->head > h->nrec) ? h->head : 0;
+        if(memcmp(h->magic, CAP_MAGIC, sizeof(h->magic)) || h->version != CAP_VERSION
+        || h->rsize != sizeof(djb2rec_t) || n < 2 || (h->nrec & (h->nrec - 1))
+        || (uint64_t)st.st_size < sizeof(*h) + h->nrec * sizeof(*r)
+        || (rplr = mmap(NULL, n * sizeof(*r), PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED) {
+            rplr = NULL; munmap(p, st.st_size); errno = EINVAL; return -1;
+        }
+        for(uint64_t i = 0; i < n; i++)     // oldest first, linear
+            rplr[i] = r[(o + i) & (h->nrec - 1)];
+        rpln = n; c->tpus = h->tpus;
+        munmap(p, st.st_size);
+    }
+    clksrc = c;
+    jprobe = jp_none;
+    return 0;
+}
+
+#ifndef _USE_TINY
+static inline void djb2cap(uint64_t tm, uint64_t dlt, uint64_t dff,
+    uint32_t cpuid, uint8_t excp, uint8_t flags)
+{
+    uint64_t i = __atomic_fetch_add(&caph->head, 1, __ATOMIC_RELAXED);
+    djb2rec_t *r = &capr[i & (caph->nrec - 1)];
+    r->tm = tm; r->dlt = dlt; r->dff = dff;
+    r->cpuid = cpuid; r->excp = excp; r->flags = flags;
+}
 #endif
 
 #define dtskew(x) (!x || (x)>>28)    // 2^29 is the biggest 2^n before 1E9
 
-#define djb2tum_status_init { 0,-1,0, 0,-1,0, 0,-1,0, 0,0,0, 0,-1,0, HSHSEED }
+/*
+ * Lanes: the clock read and the sched_yield() are the cost of each round while
+ * the mixing arithmetic is almost free, thus the same distilled sample can feed
+ * more hash states, each one with its own rotations, to have more words for
+ * each yield. All the LNMAX lanes are updated with a constant trip count and
+ * no multiplications, in such a way the compiler vectorises the loop with SSE2
+ * or AVX2 (e.g. -mavx2) for the 32/64-bit sets. Lanes share the same samples:
+ * they multiply the output for syscall, not the entropy that is harvested.
+ */
+static const uint8_t lnrot[LNMAX] = { 5, 11, 17, 23, 29, 37, 43, 53 };
+
+static inline void djb2lanes(archul_t *lhs, archul_t e) {
+    for(uint8_t k = 0; k < LNMAX; k++) {
+        archul_t l = lhs[k] + rotlbit(e, lnrot[k]);
+        lhs[k] = l ^ rotlbit(l, lnrot[LNMAX-1-k]) ^ (l >> ABz);
+    }
+}
+
+static inline archul_t djb2lane(djb2_t *s, uint8_t k, archul_t seed) {
+    archul_t o = s->lhs[k] ^= seed;  // as hsh, the input is in the lane state
+    return murmux3(o, s->ohs ^ k);   // whitening the lane before deliver
+}
+
+static inline void djb2tum_fold(djb2_t *s) {
+    s->tncl += s->ncl;   s->ncl = 0;
+    s->tdmx  = MAX(s->dmx, s->tdmx);
+    s->tdmn  = MIN(s->dmn, s->tdmn);
+}
+
+static inline int djb2tum_dispatch(void);
+
+static inline uint32_t hdrbkt(uint64_t v) {
+    if( v < (1 << HDR_SUBB) ) return v;
+    uint32_t e = 63 - __builtin_clzll(v);
+    return ((e - HDR_SUBB + 1) << HDR_SUBB) |
+        ((v >> (e - HDR_SUBB)) & ((1 << HDR_SUBB) - 1));
+}
+
+uint64_t djb2hdr_value(uint32_t b) {
+    if( b < (1 << HDR_SUBB) ) return b;
+    uint32_t e = (b >> HDR_SUBB) + HDR_SUBB - 1;
+    return (uint64_t)((1 << HDR_SUBB) | (b & ((1 << HDR_SUBB) - 1))) << (e - HDR_SUBB);
+}
+
+uint64_t djb2hdr_quantile(const uint64_t *h, double q) {
+    uint64_t n = 0, c = 0;
+    uint32_t b;
+    for(b = 0; b < HDR_NBKT; b++) n += h[b];
+    for(b = 0; b < HDR_NBKT; b++)
+        if( (c += h[b]) && c >= q * n ) break;
+    return djb2hdr_value(MIN(b, HDR_NBKT - 1));
+}
+
+// fixed cost for each sample: two compares, the sticky bits tell which failed
+static inline void djb2hlt(djb2hlt_t *h, uint64_t v, uint32_t *fl, uint32_t rct) {
+    if( v == h->rv ) { if( ++h->rc >= HLT_RCTC ) *fl |= rct; }
+    else             { h->rv = v; h->rc = 1; }
+    if( !h->an )     { h->av = v; h->ac = 1; }
+    else
+    if( v == h->av && ++h->ac >= HLT_APTC ) *fl |= rct << 1;
+    if( ++h->an == HLT_APTW ) h->an = 0;
+}
+
+uint32_t djb2tum_health(const djb2_t *s) {
+    return s->hfl;
+}
+
+#ifdef _USE_TINY
+// log2(x) in 1/256 bit, x > 0: the MSB position then 8 bits by squaring
+static inline uint32_t lg2q8(uint64_t x) {
+    uint32_t r = 63 - __builtin_clzll(x);
+    uint64_t m = (r > 31) ? x >> (r - 31) : x << (31 - r);   // [1, 2) in Q31
+    r <<= 8;
+    for(uint32_t b = 128; b; b >>= 1) {
+        m = (m * m) >> 31;
+        if(m >> 32) { m >>= 1; r += b; }
+    }
+    return r;
+}
+
+static inline uint64_t isqrt64(uint64_t x) {
+    uint64_t r = 0, b = 1ULL << 62;
+    while(b > x) b >>= 2;
+    for(; b; b >>= 2) {
+        if(x >= r + b) { x -= r + b; r = (r >> 1) + b; } else r >>= 1;
+    }
+    return r;
+}
+#endif
+
+// slides the min-entropy window by halving the counts, out of the hot loop
+static void __attribute__((noinline)) djb2hmnw(djb2_t *s) {
+    for(uint32_t i = 0; i < HMN_BINS; i++) s->mch[i] >>= 1;
+    s->mcn = HMN_WIN >> 1;           // about the samples that are left
+}
+
+uint32_t djb2tum_hmin(const djb2_t *s) {
+    uint64_t n = 0, mx = 0;
+    for(uint32_t i = 0; i < HMN_BINS; i++) {
+        n += s->mch[i]; mx = MAX(mx, s->mch[i]);
+    }
+    if(n < HMN_WARM) return 0;
+    // upper bound of the MCV probability at 99%, as SP 800-90B 6.3.1
+#ifdef _USE_TINY // the same in fixed point, p in Q32 and h in 1/256 bit
+    uint64_t p = (mx << 32) / n, v = ((p * ((1ULL << 32) - p)) >> 32) / (n - 1);
+    p = MIN(1ULL << 32, p + isqrt64(v << 32) * 2576 / 1000);
+    p = MIN(32 << 8, lg2q8(p) + 2);  // +2: never above the double one
+    uint32_t h = MIN((32 << 8) - p, __builtin_ctz(HMN_BINS) << 8);
+    if(s->jmn != (uint64_t)-1 && s->jmx > s->jmn)    // a range, 2+ samples
+        h = MIN(h, lg2q8(s->jmx - s->jmn + 1));
+#else
+    double p = (double)mx / n;
+    p = MIN(1.0, p + 2.576 * sqrt(p * (1 - p) / (n - 1)));
+    double h = MIN(-log2(p), __builtin_ctz(HMN_BINS));
+    if(s->jmn != (uint64_t)-1 && s->jmx > s->jmn)    // a range, 2+ samples
+        h = MIN(h, log2((double)(s->jmx - s->jmn) + 1));
+    h *= 256;
+#endif
+    return MAX(1, (uint32_t)h);      // 0 is for the warm-up only
+}
+
+/** PROFILING *****************************************************************/
+/*
+ * With -D_USE_PROFILING each stage of the hot loop is timed by the cheapest
+ * counter (TSC, CNTVCT, else the raw monotonic ns) and the gotos are counted,
+ * by thread without atomics and folded when the thread ends: the table at the
+ * exit tells which stage is worth optimising on each arch. Every stage pays
+ * one counter read, it is the "tick" in the table. Without it, no code at all.
+ */
+#ifdef _USE_PROFILING
+enum { PRF_PREP, PRF_TIME, PRF_LTNC, PRF_STTS, PRF_JTTR, PRF_DSTL, PRF_MMIX,
+    PRF_INJC, PRF_NEXT, PRF_RSCH, PRF_PRBE, PRF_FINL, PRF_NSTG };
+enum { PRG_RSCH, PRG_NCRS, PRG_SKPE, PRG_LOOP, PRG_NGTO };
+
+typedef struct {
+    uint64_t cyc[PRF_NSTG + 1], cnt[PRF_NSTG + 1];   // +1, the closing one
+    uint64_t gto[PRG_NGTO];
+} djb2prf_t;
+
+static __thread djb2prf_t prfl;      // the thread's one, for the hot loop
+static djb2prf_t prfg;               // the totals of the ended threads
+
+static inline uint64_t prftick(void) {
+#if HAS_RDTSC
+    return __rdtsc();
+#elif HAS_CNTVCT
+    return get_cntvct_clock(NULL);
+#else
+    return getclkns(CLOCK_MONOTONIC_RAW);
+#endif
+}
+
+// it closes the running stage and opens the n-th one
+#define PRF(n) { uint64_t t = prftick(); prfl.cyc[prfs] += t - prft; \
+    prfl.cnt[prfs]++; prfs = (n); prft = t; }
+#define PRG(g) prfl.gto[PRG_##g]++;
+#define PRF_VARS uint64_t prft = prftick(); uint32_t prfs = PRF_NSTG; // p.1 out
+
+static void djb2prf_fold(void) {
+    for(uint32_t i = 0; i < PRF_NSTG; i++) {
+        __atomic_fetch_add(&prfg.cyc[i], prfl.cyc[i], __ATOMIC_RELAXED);
+        __atomic_fetch_add(&prfg.cnt[i], prfl.cnt[i], __ATOMIC_RELAXED);
+    }
+    for(uint32_t i = 0; i < PRG_NGTO; i++)
+        __atomic_fetch_add(&prfg.gto[i], prfl.gto[i], __ATOMIC_RELAXED);
+    memset(&prfl, 0, sizeof(prfl));
+}
+#else
+#define PRF(n)
+#define PRG(g)
+#define PRF_VARS
+#endif
+
+void djb2tum_init(djb2_t *s) {
+    *s = (djb2_t)djb2tum_status_init;
+    (void) djb2tum_dispatch();       // once, before any thread would need it
+}
+
+void djb2tum_rset(djb2_t *s) {
+    djb2tum_fold(s);
+    s->dmn = -1, s->dmx = 0, s->ncl = 0; s->ons = 0;
+}
+
+djb2_t *djb2tum_stats(djb2_t *s, uint32_t pmdly) {
+    djb2tum_fold(s);
+    s->pmns = PMDLY2NS(s->tdmn);
+    return s;
+}
+
+// the replay output digest and the state checksum, not a secure one
+static inline uint64_t fnv1a64(uint64_t h, const uint8_t *p, uint32_t n) {
+    while(n--) h = (h ^ *p++) * 0x100000001B3ULL;
+    return h;
+}
+
+int djb2tum_save(const djb2_t *s, const char *path, uint8_t nbtls) {
+    struct { djb2sth_t h; djb2_t s; } st;
+    char tmp[4096];
+    memset(&st, 0, sizeof(st));
+    memcpy(st.h.magic, STT_MAGIC, sizeof(st.h.magic));
+    st.h.version = STT_VERSION; st.h.abn = ABN; st.h.size = sizeof(djb2_t);
+    st.h.nbtls = nbtls;
+    strncpy(st.h.clock, clksrc->name, sizeof(st.h.clock) - 1);
+    st.s = *s; st.s.hdr = NULL;
+    st.h.cksum = fnv1a64(HSHSEED, (uint8_t *)&st.s, sizeof(st.s));
+
+    size_t n = strlen(path);
+    if(n + sizeof(".tmp") > sizeof(tmp)) {
+        errno = ENAMETOOLONG; return -1;
+    }
+    memcpy(tmp, path, n); memcpy(tmp + n, ".tmp", sizeof(".tmp"));
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0600);   // it is a secret
+    if(fd < 0) return -1;
+    if(write(fd, &st, sizeof(st)) != sizeof(st) || fsync(fd)) {
+        close(fd); unlink(tmp); return -1;
+    }
+    close(fd);
+    return rename(tmp, path);
+}
+
+int djb2tum_load(djb2_t *s, const char *path, uint8_t nbtls) {
+    struct { djb2sth_t h; djb2_t s; } st;
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return -1;
+    ssize_t n = read(fd, &st, sizeof(st));
+    close(fd);
+    if(n != sizeof(st) || memcmp(st.h.magic, STT_MAGIC, sizeof(st.h.magic))
+    || st.h.version != STT_VERSION || st.h.abn != ABN
+    || st.h.size != sizeof(djb2_t) || st.h.nbtls != nbtls
+    || strncmp(st.h.clock, clksrc->name, sizeof(st.h.clock))
+    || st.h.cksum != fnv1a64(HSHSEED, (uint8_t *)&st.s, sizeof(st.s))) {
+        errno = EINVAL; return -1;
+    }
 
-static archul_t djb2tum(archul_t seed, uint8_t maxn, uint32_t nsdly,
-    uint32_t pmdly, uint8_t nbtls, uint8_t rset)
+    // the warm part: min/max trackings, hash and lanes states, dff histogram
+    s->dmn  = st.s.dmn;  s->dmx  = st.s.dmx;  s->tdmn = st.s.tdmn;
+    s->tdmx = st.s.tdmx; s->jmn  = st.s.jmn;  s->jmx  = st.s.jmx;
+    s->ohs  = st.s.ohs;  s->pmns = st.s.pmns;
+    memcpy(s->lhs, st.s.lhs, sizeof(s->lhs));
+    memcpy(s->mch, st.s.mch, sizeof(s->mch)); s->mcn = st.s.mcn;
+    // fresh timing and pid mixed in, thus a state is never replayed verbatim
+    s->ohs = murmux3(s->ohs, getnstime(NULL) ^ ((archul_t)getpid() << ABx));
+    for(uint8_t k = 0; k < LNMAX; k++) s->lhs[k] = murmux3(s->lhs[k], s->ohs ^ k);
+    return 0;
+}
+
+static inline __attribute__((always_inline))
+archul_t djb2tum(djb2_t *s, archul_t seed, uint8_t maxn,
+    uint32_t nsdly, uint32_t pmdly, uint8_t nbtls)
 {
-    // This is the internal state of the engine
-    static djb2_t s = djb2tum_status_init;
     /*
      * In general, the previous time shouldn't be persistent across calls
      * but this function is running in strict sequence in a manner that
-     * it makes sense keep the ons static, also because dtskew() exists
+     * it makes sense keep the ons in the context, also because dtskew()
      */
 #ifndef _USE_PREV_TIME
-    static
-#endif
+    archul_t __attribute__((aligned(16))) ons = s->ons;
+#else
     archul_t __attribute__((aligned(16))) ons = 0;
+#endif
 
-    if( s.ncl || s.tncl || rset || seed == DJB2VGET ) {
-        s.tncl += s.ncl;   s.ncl = 0;
-        s.tdmx  = MAX(s.dmx, s.tdmx);
-        s.tdmn  = MIN(s.dmn, s.tdmn);
-        s.pmns  = PMDLY2NS  (s.tdmn);
-    }
-
-    if( rset ) { s.dmn = -1, s.dmx = 0, s.ncl = 0; ons = 0; };
-
-    // The best practice is to share a copy not the internal state
-    if( seed == DJB2VGET ) return (uintptr_t)&s;
+    if( s->ncl || s->tncl ) djb2tum_fold(s);
 
     if( !maxn ) return 0;
+    PRF_VARS
 
     // 0. hashing loop preparation, p.1 ////////////////////////////////////////
 
-    archul_t __attribute__((aligned(16))) tm_4s_nsec, dff, dlt, ent = 0;
-    register archul_t hsh = s.ohs;
+    archul_t __attribute__((aligned(16))) tm_4s_nsec, dff = 0, dlt = 0, ent = 0;
+    register archul_t hsh = s->ohs;
     uint8_t skw = !!ons, excp = 0;   // excp++ as uint8_t grants for convergence
+    uint32_t nrsc = 0;               // reschedules for this word
 
     if( seed ) hsh ^= seed;
 
 hashotloop:                                      // a loop made by two ASM jumps
 /** HASHING LOOP START  *******************************************************/
     // 0. hashing loop preparation, p.2 ////////////////////////////////////////
+    PRF(PRF_PREP)
 
     if( ent ) ent ^= rotlbit(ent, getprmx16(hsh));
 
     // 1. ns latency time retrievement /////////////////////////////////////////
+    PRF(PRF_TIME)
 
-#if USE_GET_TIME
-    tm_4s_nsec = getnstime( NULL ) >> nbtls;
-#else
-    uint32_t cpuid;
+    uint32_t cpuid = -1;             // only the TSC source reports the CPU id
+    uint8_t rsch = CAP_RSCHD;        // for the capture, cleared when hashed
     tm_4s_nsec = getnstime(&cpuid) >> nbtls;
-    if( cpuid != (uint32_t)s.oid && s.oid != -1 ) {
-        // Knuth, based on gold section seeded by CPU ids event idx
-        hsh = murmux3(hsh, ((archul_t)cpuid << ABy) | s.oid);
-        // reschedule in the following !ons branch
-        ons = 0;
-        s.nexp++;
+    if( cpuid != (uint32_t)-1 ) {
+        if( cpuid != (uint32_t)s->oid && s->oid != -1 ) {
+            // Knuth, based on gold section seeded by CPU ids event idx
+            hsh = murmux3(hsh, ((archul_t)cpuid << ABy) | s->oid);
+            // reschedule in the following !ons branch
+            ons = 0;
+            s->nexp++;
+        }
+        s->oid = cpuid;
     }
-    s.oid = cpuid;
-#endif
-    if( !ons ) { hsh = knuthmx(hsh ^ tm_4s_nsec);         goto reschedule;    }
+    if( !ons ) { hsh = knuthmx(hsh ^ tm_4s_nsec); PRG(RSCH) goto reschedule;   }
 
     // 2. latency calculation //////////////////////////////////////////////////
+    PRF(PRF_LTNC)
 
-    dlt = tm_4s_nsec - ons;       // within 4s is fine, with RTCS is always fine
-    if( dtskew(dlt) ) {                                    goto reschedule;    }
-    if( s.dmn == -1 ) { s.dmn = dlt;                       goto reschedule;    }
-    if( skw )         {                                    goto notcrashstats; }
+    dlt = tm_4s_nsec - ons;       // full-width clocks, the delta is always fine
+    djb2hlt(&s->hlt[0], dlt, &s->hfl, HLT_RCT_DLT);   // before, a stuck clock
+    if( s->hdr ) s->hdr->dlt[hdrbkt(dlt)]++;
+    if( dtskew(dlt) ) {                      PRG(RSCH) goto reschedule;    }
+    if( s->dmn == -1 ) { s->dmn = dlt;       PRG(RSCH) goto reschedule;    }
+    if( skw )         {                      PRG(NCRS) goto notcrashstats; }
 
     // 3. internal state update ////////////////////////////////////////////////
+    PRF(PRF_STTS)
 
     // dmn calculation is mandatory for stochastics bi-forkation turns
-    if( dlt < s.dmn ) {
-        dff = s.dmn - dlt; s.dmn = dlt;
-        ent ^= -dff ^ s.dmn;
-        s.evnt++;
+    if( dlt < s->dmn ) {
+        dff = s->dmn - dlt; s->dmn = dlt;
+        ent ^= -dff ^ s->dmn;
+        s->evnt++;
     } else
     // dmx calculation can be omited but doing ns*=0x4d anyway
-    if( dlt > s.dmx ) {
-        dff = dlt - s.dmn; s.dmx = dlt;
-        ent ^= dff ^ -s.dmx;
-        s.evnt++;
+    if( dlt > s->dmx ) {
+        dff = dlt - s->dmn; s->dmx = dlt;
+        ent ^= dff ^ -s->dmx;
+        s->evnt++;
     } else {
 notcrashstats:
-        dff = dlt - s.dmn;
-        ent ^= ~dff ^ s.dmx;
+        dff = dlt - s->dmn;
+        ent ^= ~dff ^ s->dmx;
     }
-    if( !dff ) { hsh = knuthmx(hsh); skw = 0;             goto reschedule;    }
+    djb2hlt(&s->hlt[1], dff, &s->hfl, HLT_RCT_DFF);
+    s->mch[dff & (HMN_BINS - 1)]++;
+    if( ++s->mcn >= HMN_WIN ) djb2hmnw(s);
+    if( s->hdr ) s->hdr->dff[hdrbkt((dff >> ABX) ? -dff : dff)]++; // |dlt-dmn|
+    if( !dff ) { hsh = knuthmx(hsh); skw = 0; PRG(RSCH) goto reschedule;    }
 
     // 4. jittering calculation ////////////////////////////////////////////////
+    PRF(PRF_JTTR)
 
     // dff is jittering for the exeption manager activation
-    if( dff < nsdly + (pmdly ? PMDLY2NS(s.dmn) : 1) + excp ) {
+    if( dff < nsdly + (pmdly ? PMDLY2NS(s->dmn) : 1) + excp ) {
         excp += 4;                   // increasing excp and accounting for dff
-        s.nexp++;
+        s->nexp++;
         skw = 0;
     } else {
         // Knuth, based on gold section seeded by 1E-3 ~ 1E-4 event idx
         if( excp ) { hsh = murmux3(hsh, ons); } excp = 0;
-        if( skw  ) { skw = 0;                              goto skiptoetropy;  }
+        if( skw  ) { skw = 0;                PRG(SKPE) goto skiptoetropy;  }
         // min,max jittering can be ommited
-        if( s.jmn == -1 ) s.jmn = dff;
+        if( s->jmn == -1 ) s->jmn = dff;
         else
-        if( dff < s.jmn ) s.jmn = dff;
-        if( dff > s.jmx ) s.jmx = dff;
+        if( dff < s->jmn ) s->jmn = dff;
+        if( dff > s->jmx ) s->jmx = dff;
         // avg calculation can be ommitted
-        s.avg += dlt; s.javg += dff; s.ncl++;
+        s->avg += dlt; s->javg += dff; s->ncl++;
     }
 
     // 5. entropy distillation /////////////////////////////////////////////////
 skiptoetropy:
+    PRF(PRF_DSTL)
     ent ^= dlt        << ABz ;       // 1st derivative of time
     ent ^= tm_4s_nsec << rot3;       // current monotonic time
     ent  = knuthmx(ent ^ dff);       // 2nd derivative of time
+    if( s->nlns > 1 )                // the same sample feeds the other lanes
+        djb2lanes(s->lhs, ent ^ dlt);
 
     // 6. macro-mix in djb2-style //////////////////////////////////////////////
+    PRF(PRF_MMIX)
     /*
      * (16+1) (32-1 or 32+1) (64-1)
      *   01     10      00     11
@@ -605,25 +1254,38 @@ skiptoetropy:
     hsh = ( hsh << (4 + (b0 ? b1 : 1)) ) + (b1 ? -hsh : hsh);
 
     // 7. entropy injection in hsh /////////////////////////////////////////////
+    PRF(PRF_INJC)
 
     // it consumes entropy, and does hash the another rotation
     hsh ^= rotlbit(hsh, getprmx16(ent));
 
     // 8. preparation for the next round ///////////////////////////////////////
+    PRF(PRF_NEXT)
 
-    s.ctot++;
+    s->ctot++; rsch = 0;
     // copying with the VMs scheduler timings: continue made by an ASM jump
 reschedule:
+    PRF(PRF_RSCH)
+#ifndef _USE_TINY
+    if(   caph        ) { djb2cap(tm_4s_nsec, dlt, dff, cpuid, excp, rsch); }
+#else
+    (void)rsch;
+#endif
     if(   skw         ) { skw = 0; }
     if( !excp         ) { maxn--; ons = tm_4s_nsec; }
-    if(  excp || maxn ) {  sched_yield();                  goto hashotloop;    }
+    PRF(PRF_PRBE)                    // also the exit branch, of the last one
+    if(  excp || maxn ) {  jprobe(); nrsc++;    PRG(LOOP) goto hashotloop;    }
 
 /** HASHING LOOP CLOSE  *******************************************************/
     // 9. finalising w/ a 32+1 bit mix /////////////////////////////////////////
+    PRF(PRF_FINL)
 
     ent = hsh;                       // forget the entropy mixed in hash
-    hsh = murmux3(hsh, s.ohs);       // whitening the hash before deliver
-    s.ohs = ent;                     // keep the hashing internal state
+    hsh = murmux3(hsh, s->ohs);       // whitening the hash before deliver
+    s->ohs = ent;                     // keep the hashing internal state
+    s->ons = ons;
+    if( s->hdr ) s->hdr->rsc[hdrbkt(nrsc)]++;
+    PRF(PRF_NSTG)
 
     return hsh;
 }
@@ -638,36 +1300,112 @@ static inline uint8_t *bin2str(uint8_t *buf, uint32_t nmax) {
     return buf;
 }
 
-archul_t *str2hsh(const uint8_t *str, archul_t *h, uint32_t *size, uint32_t nsdly,
-    uint32_t pmdly, uint8_t nbtls, uint8_t rset)
+archul_t djb2tum_next(djb2_t *s, archul_t seed, uint8_t maxn, uint32_t nsdly,
+    uint32_t pmdly, uint8_t nbtls)
+{
+    return djb2tum(s, seed, maxn, nsdly, pmdly, nbtls);
+}
+
+static inline __attribute__((always_inline))
+void djb2fill(djb2_t *s, const archul_t *p, archul_t *h, uint32_t nwords,
+    uint32_t nsdly, uint32_t pmdly, uint8_t nbtls, uint8_t rset)
+{
+    uint32_t i, n = 0;
+    uint8_t k, nl = MAX(1, MIN(s->nlns, LNMAX));
+    for (i = 0; i < nwords; i += nl) {
+        n += (ABz+1) * nl;
+        // Processing each n-bytes chunk of the rotated/padded string
+        h[i] = djb2tum(s, p[i], 1 + !!rset, nsdly, pmdly, nbtls);
+        for (k = 1; k < nl && i + k < nwords; k++)
+            h[i+k] = djb2lane(s, k, p[i+k]);
+        if ( rset && n >= ((archul_t)1 << rset) ) {
+            n = 0; djb2tum_rset(s);
+        }
+    }
+}
+
+/*
+ * The same hot loop compiled for more instruction sets and selected at runtime
+ * by CPUID, in such a way that a single static binary runs at its best on each
+ * host. It is not an ifunc because musl does not support it in static binaries.
+ * The word size (32/64/128-bit sets) stays a compile-time choice because it is
+ * the hash itself, not a matter of speed: each set gives a different output.
+ */
+#define DJB2FILL(name, attr) static attr void djb2fill_##name(djb2_t *s,\
+    const archul_t *p, archul_t *h, uint32_t nwords, uint32_t nsdly,\
+    uint32_t pmdly, uint8_t nbtls, uint8_t rset)\
+    { djb2fill(s, p, h, nwords, nsdly, pmdly, nbtls, rset); }
+
+typedef void (*djb2fill_t)(djb2_t *, const archul_t *, archul_t *, uint32_t,
+    uint32_t, uint32_t, uint8_t, uint8_t);
+
+DJB2FILL(base, )
+#ifdef __x86_64__
+DJB2FILL(x86v2, __attribute__((target("popcnt,sse4.2"))))
+DJB2FILL(x86v3, __attribute__((target("popcnt,sse4.2,avx,avx2,bmi,bmi2"))))
+#endif
+
+static const struct {
+    const char *name;
+    djb2fill_t fill;
+} djb2vars[] = {
+#ifdef __x86_64__
+    { "x86-64",    djb2fill_base  },
+    { "x86-64-v2", djb2fill_x86v2 },
+    { "x86-64-v3", djb2fill_x86v3 },
+#else
+    { "generic",   djb2fill_base  },
+#endif
+};
+
+static int djb2var = -1;
+
+static inline int djb2tum_dispatch(void) {
+    if(djb2var >= 0) return djb2var;
+    int v = 0;
+#ifdef __x86_64__
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("popcnt") && __builtin_cpu_supports("sse4.2")) {
+        v = 1;
+        if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2"))
+            v = 2;
+    }
+#endif
+    return (djb2var = v);
+}
+
+const char *djb2tum_variant(void) {
+    return djb2vars[djb2tum_dispatch()].name;
+}
+
+archul_t *str2hsh(djb2_t *s, const uint8_t *str, archul_t *h, uint32_t *size,
+    uint32_t nsdly, uint32_t pmdly, uint8_t nbtls, uint8_t rset)
 {
-    if (!str || !size) return NULL;
+    if (!s || !str || !size) return NULL;
 
     // 1. Calculate allocation
     // We need enough 64-bit blocks to cover n bytes.
-    uint32_t i, n = 0, nwords = (*size + ABz) >> ABL;
+    uint32_t nwords = (*size + ABz) >> ABL;
 
     // 2. Generate the words-sized array
     // We allocate a separate array for hashes if that was the intent, or we cast
     // the rotated string. Based on your code, you want a hash per 8-byte block.
     if(h == NULL) {
+#ifdef _USE_TINY
+        errno = ENOMEM;              // no heap, the caller owns the words
+        return NULL;
+#else
         if(posix_memalign((void **)&h, ALGN, nwords << ABL) || !h) {
             perror("posix_memalign");
             return NULL;
         }
+#endif
     }
     *size = nwords;
 
-    // 3. Producing the hashing sequence
-    archul_t *p = (archul_t *)str;
-    for (i = 0; i < nwords; i++) {
-        n += ABz+1;
-        // Processing each n-bytes chunk of the rotated/padded string
-        h[i] = djb2tum(p[i], 1 + !!rset, nsdly, pmdly, nbtls, 0);
-        if ( rset && n >= ((archul_t)1 << rset) ) {
-            n = 0; djb2tum(0, 0, 0, 0, 0, 1);
-        }
-    }
+    // 3. Producing the hashing sequence, by the CPU variant
+    djb2vars[djb2tum_dispatch()].fill(s, (const archul_t *)str, h, nwords,
+        nsdly, pmdly, nbtls, rset);
 
     return h;
 }
@@ -750,10 +1488,21 @@ static inline uint32_t readblocks(int fd, uint8_t *buf, uint32_t *nblks) {
 }
 
 /* ** main & its supporters ************************************************* */
+#ifndef _UCHAOS_LIB
 
-// Funzione per ottenere il tempo in nanosecondi
-static uint64_t get_nanos(void) {
-    static uint64_t start = 0;
+#define APPNAME "uChaos"
+#ifdef _USE_GET_RTSC
+#define CLK_DEFAULT "tsc"
+#else
+#define CLK_DEFAULT "auto"
+#endif
+#define OPTNK "option -k is designed for /dev/[u]random only"
+
+typedef double __attribute__((aligned(8))) df;
+
+// Funzione per ottenere il tempo in nanosecondi
+static uint64_t get_nanos(void) {
+    static uint64_t start = 0;
     struct timespec ts;
 
     clock_gettime(CLOCK_MONOTONIC, &ts);
@@ -764,23 +1513,704 @@ static uint64_t get_nanos(void) {
     return ((uint64_t)ts.tv_sec * E9 + ts.tv_nsec) - start;
 }
 
+/*
+ * The -k credit for sz bytes made by nsmp raw samples: the measured min-entropy
+ * for each sample, but at most ecap bits for each byte, or the fixed entropy()
+ * policy while the estimate is warming up. Both are capped at HLT_H bits for
+ * each sample, the claim of the health tests cutoffs (uchaos.h). The lanes do
+ * not multiply it.
+ */
+static inline uint32_t djb2credit(djb2_t *s, uint64_t nsmp, uint32_t sz,
+    uint8_t ecap)
+{
+    uint64_t h = djb2tum_hmin(s);
+    uint64_t b = h ? (h * nsmp) >> 8 : entropy(sz);
+    b = MIN(b, nsmp * HLT_H);
+    return MIN(b, (uint64_t)ecap * sz);
+}
+
+#ifndef _USE_TINY
+/** BULK OUTPUT *************************************************************/
+/*
+ * A -G/-M run writes hundreds of millions of 512 bytes blocks, one syscall for
+ * each of them. The output stage collects them in two large buffers, in the
+ * same mapping advised for transparent huge pages. When stdout is a pipe, the
+ * pipe is resized as a buffer and a full buffer is gifted by vmsplice(), then
+ * the other buffer is filled: once vmsplice() returned, the pipe holds only
+ * the pages of the last buffer, thus the reader consumed the previous one and
+ * it can be overwritten. Otherwise a full buffer goes out by a large write().
+ */
+
+#define OB_SIZE  (1 << 20)           // per buffer, the default pipe-max-size
+#define OB_HPSZ  (1 << 21)           // huge page size, for the alignment
+
+enum { OB_WRITE = 0, OB_SPLICE };
+static const char *obmode[] = { "write", "vmsplice" };
+
+typedef struct {
+    uint8_t *buf[2];                 // double buffers, buf[cur] is filling
+    uint32_t size, used;
+    uint8_t  cur, mode;
+    int      fd;
+    uint64_t nbytes, ns;             // bytes out and time spent to put them
+} outbuf_t;
+
+static int outbuf_init(outbuf_t *ob, int fd) {
+    struct stat st;
+    memset(ob, 0, sizeof(*ob));
+    ob->fd = fd; ob->size = OB_SIZE; ob->mode = OB_WRITE;
+    if(!fstat(fd, &st) && S_ISFIFO(st.st_mode)) {
+        int psz = fcntl(fd, F_SETPIPE_SZ, OB_SIZE);
+        if(psz < 0) psz = fcntl(fd, F_GETPIPE_SZ);
+        if(psz >= BLOCK_SIZE) {
+            ob->size = MIN(psz, OB_SIZE) & ~(BLOCK_SIZE - 1);
+            ob->mode = OB_SPLICE;
+        }
+    }
+    size_t len = OB_HPSZ + 2 * (size_t)OB_SIZE;
+    uint8_t *p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(p == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+    p = (uint8_t *)(((uintptr_t)p + OB_HPSZ - 1) & ~(uintptr_t)(OB_HPSZ - 1));
+    madvise(p, 2 * (size_t)OB_SIZE, MADV_HUGEPAGE); // best effort, no check
+    ob->buf[0] = p; ob->buf[1] = p + ob->size;
+    return 0;
+}
+
+static void outbuf_flush(outbuf_t *ob) {
+    if(!ob->used) return;
+    uint64_t stns = get_nanos();
+    struct iovec iov = { ob->buf[ob->cur], ob->used };
+    while(ob->mode == OB_SPLICE && iov.iov_len) {
+        errno = 0;
+        ssize_t nw = vmsplice(ob->fd, &iov, 1, SPLICE_F_GIFT);
+        if(nw < 0) {
+            if(errno == EINTR) continue;
+            if(errno != EINVAL && errno != ENOSYS) {
+                perror("vmsplice");
+                exit(EXIT_FAILURE);
+            }
+            ob->mode = OB_WRITE;     // e.g. a pipe of a special kind
+            break;
+        }
+        iov.iov_base = (uint8_t *)iov.iov_base + nw;
+        iov.iov_len -= nw;
+    }
+    if(iov.iov_len) writebuf(ob->fd, iov.iov_base, iov.iov_len);
+    ob->nbytes += ob->used;
+    ob->used = 0; ob->cur ^= 1;
+    ob->ns += get_nanos() - stns;
+}
+
+static inline void outbuf_put(outbuf_t *ob, const uint8_t *p, uint32_t n) {
+    while(n) {
+        uint32_t k = MIN(n, ob->size - ob->used);
+        memcpy(ob->buf[ob->cur] + ob->used, p, k);
+        ob->used += k; p += k; n -= k;
+        if(ob->used == ob->size) outbuf_flush(ob);
+    }
+}
+
+/** THREADS *******************************************************************/
+/*
+ * Every -j worker owns a generator context, pinned on its own CPU, and pushes
+ * its blocks into its own single-producer single-consumer ring. The merger in
+ * main() pops the blocks in round-robin, thus the output order is determined
+ * by the block index and not by which thread is faster. Both sides just spin
+ * on sched_yield() while waiting, which is the same perturbation djb2tum uses.
+ */
+
+#define RING_SLOTS 64                // power of 2, 32KB of hashes per worker
+#define RING_MASK (RING_SLOTS-1)
+#define MAX_THRDS 64
+#define RING_SPINS 1024              // yields before to start sleeping
+#define RING_NSLEEP (50 * E3)        // ns of sleep while waiting for a slow side
+
+typedef struct {
+    _Atomic uint32_t head __attribute__((aligned(64)));  // producer side
+    _Atomic uint32_t tail __attribute__((aligned(64)));  // consumer side
+    uint32_t size[RING_SLOTS] __attribute__((aligned(64)));
+    uint32_t crd[RING_SLOTS];        // bits of entropy to credit for each block
+    block512_t blk[RING_SLOTS];
+} ring_t;
+
+// yielding while the other side is fast, sleeping when it is not (e.g. stdin)
+static inline void ring_wait(uint32_t *nw) {
+    if(++(*nw) < RING_SPINS) sched_yield(); else nsleep(RING_NSLEEP);
+}
+
+static inline block512_t *ring_wget(ring_t *r) {
+    uint32_t nw = 0, h = atomic_load_explicit(&r->head, memory_order_relaxed);
+    while(h - atomic_load_explicit(&r->tail, memory_order_acquire) >= RING_SLOTS)
+        ring_wait(&nw);
+    return &r->blk[h & RING_MASK];
+}
+
+static inline void ring_wput(ring_t *r, uint32_t size) {
+    uint32_t h = atomic_load_explicit(&r->head, memory_order_relaxed);
+    r->size[h & RING_MASK] = size;
+    atomic_store_explicit(&r->head, h + 1, memory_order_release);
+}
+
+static inline block512_t *ring_rget(ring_t *r, uint32_t *size) {
+    uint32_t nw = 0, t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    while(atomic_load_explicit(&r->head, memory_order_acquire) == t)
+        ring_wait(&nw);
+    *size = r->size[t & RING_MASK];
+    return &r->blk[t & RING_MASK];
+}
+
+// the credit travels with the block: set before ring_wput, get before rput
+static inline void ring_wcrd(ring_t *r, uint32_t bits) {
+    r->crd[atomic_load_explicit(&r->head, memory_order_relaxed) & RING_MASK] = bits;
+}
+
+static inline uint32_t ring_rcrd(ring_t *r) {
+    return r->crd[atomic_load_explicit(&r->tail, memory_order_relaxed) & RING_MASK];
+}
+
+static inline void ring_rput(ring_t *r) {
+    atomic_fetch_add_explicit(&r->tail, 1, memory_order_release);
+}
+
+typedef struct {
+    pthread_t tid;
+    ring_t *rng;
+    djb2_t ctx;
+    const uint8_t *str;
+    uint32_t n, nblk, nrdry, nsdly, pmdly;
+    uint8_t idx, nbtls, rset, nlns, ecap;
+    int cpu;
+    djb2hdr_t *hdr;
+    uint64_t st, et;                 // ns of the hashing, after the dry runs
+} worker_t;
+
+static void *worker(void *arg) {
+    worker_t *w = (worker_t *)arg;
+
+    if(w->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set); CPU_SET(w->cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    // same input for all, thus the workers start from distinct states
+    djb2tum_init(&w->ctx);
+    w->ctx.ohs ^= (uint64_t)knuthmx(w->idx + 1);
+    w->ctx.nlns = w->nlns;
+    w->ctx.hdr = w->hdr;
+
+    block512_t *bp = ring_wget(w->rng);
+    for(uint32_t a = w->nrdry; a; a--) {
+        uint32_t size = w->n;
+        str2hsh(&w->ctx, w->str, bp->dt, &size, w->nsdly, w->pmdly, w->nbtls, 0);
+    }
+    w->st = get_nanos();
+    for(uint32_t a = w->nblk; a; a--) {
+        uint32_t size = w->n;
+        uint64_t ctot = w->ctx.ctot;
+        bp = ring_wget(w->rng);
+        str2hsh(&w->ctx, w->str, bp->dt, &size, w->nsdly, w->pmdly, w->nbtls,
+            w->rset);
+        if(djb2tum_health(&w->ctx)) size = 0;   // main() stops on this block
+        ring_wcrd(w->rng, djb2credit(&w->ctx, w->ctx.ctot - ctot, size << ABL,
+            w->ecap));
+        ring_wput(w->rng, size);
+        if(!size) break;
+    }
+    w->et = get_nanos();
+#ifdef _USE_PROFILING
+    djb2prf_fold();
+#endif
+    return NULL;
+}
+
+// the totals of all the workers in a single context for the final report
+static void djb2tum_merge(djb2_t *d, djb2_t *s) {
+    djb2tum_stats(s, 0);
+    d->tncl += s->tncl; d->ctot += s->ctot; d->evnt += s->evnt;
+    d->nexp += s->nexp; d->javg += s->javg; d->avg  += s->avg;
+    d->tdmn  = MIN(d->tdmn, s->tdmn); d->tdmx = MAX(d->tdmx, s->tdmx);
+    d->dmn   = MIN(d->dmn,  s->tdmn); d->dmx  = MAX(d->dmx,  s->tdmx);
+    d->jmn   = MIN(d->jmn,  s->jmn);  d->jmx  = MAX(d->jmx,  s->jmx);
+    if(d->hdr && s->hdr) for(uint32_t b = 0; b < HDR_NBKT; b++) {
+        d->hdr->dlt[b] += s->hdr->dlt[b]; d->hdr->dff[b] += s->hdr->dff[b];
+        d->hdr->rsc[b] += s->hdr->rsc[b];
+    }
+}
+
+/** RUN-WIDE DUPLICATES *******************************************************/
+/*
+ * With -m MB the analyser checks each word against all the words of the run,
+ * not only against those of its own block. The recent words stay in an exact
+ * open-addressing table; when it is half full, its records are sorted by word
+ * and spilled as a run into a temporary file, after being added to a Bloom
+ * filter. A word the filter may have seen is a candidate and it is verified
+ * at the end, scanning the sorted runs once along with the sorted candidates.
+ * The budget is split as 1/2 table, 1/4 filter and 1/4 candidates. When the
+ * candidates overflow (the budget is too small for the run), the check goes on
+ * but it is not complete anymore and that is reported.
+ *
+ * The positions are block.word, e.g. 12.3:4567.8 is word 3 of block 12 which
+ * repeats as word 8 of block 4567; the in-block repetitions are not repeated.
+ */
+
+typedef struct {
+    archul_t w;
+    uint64_t pos;                    // block << 8 | word, + 1 thus 0 is empty
+} duprec_t;
+
+typedef struct {
+    duprec_t *tbl, *cnd;
+    uint64_t *blm;
+    uint64_t  tmsk, bmsk, ntbl, ncnd, mcnd, nk;
+    uint64_t *runs;                  // records for each spilled run
+    uint32_t  nrun;
+    uint8_t   ovf;
+    FILE     *fp;
+} dupd_t;
+
+#define DUP_POS(b,n) ( ( ( (uint64_t)(b) << 8 ) | (n) ) + 1 )
+#define DUP_BLK(p)   ( ( (p) - 1 ) >> 8 )
+#define DUP_WRD(p)   ( ( (p) - 1 ) & 0xFF )
+
+static inline uint64_t duphsh(archul_t w) {
+    uint64_t f = (uint64_t)w ^ (uint64_t)(w >> (ABN >> 1)) * 0xBF58476D1CE4E5B9ULL;
+    f ^= f >> 31; f *= 0x94D049BB133111EBULL;
+    return f ^ (f >> 29);
+}
+
+static inline uint64_t pow2le(uint64_t n) {
+    return n ? 1ULL << (63 - __builtin_clzll(n)) : 0;
+}
+
+static dupd_t *dupd_init(uint32_t mb) {
+    uint64_t sz = (uint64_t)mb << 20;
+    dupd_t *d = calloc(1, sizeof(*d));
+    if(!d) return NULL;
+    d->tmsk = pow2le((sz >> 1) / sizeof(duprec_t)) - 1;
+    d->bmsk = pow2le((sz >> 2) << 3) - 1;
+    d->mcnd = (sz >> 2) / sizeof(duprec_t);
+    d->tbl  = calloc(d->tmsk + 1, sizeof(duprec_t));
+    d->blm  = calloc((d->bmsk + 1) >> 6, sizeof(uint64_t));
+    d->cnd  = malloc(d->mcnd * sizeof(duprec_t));
+    if(!d->tbl || !d->blm || !d->cnd) {
+        free(d->tbl); free(d->blm); free(d->cnd); free(d);
+        return NULL;
+    }
+    return d;
+}
+
+static inline int dupcmp(const void *a, const void *b) {
+    archul_t x = ((const duprec_t *)a)->w, y = ((const duprec_t *)b)->w;
+    return (x > y) - (x < y);
+}
+
+static inline uint8_t blm_test(dupd_t *d, uint64_t h, uint8_t set) {
+    uint8_t r = 1;
+    for(uint64_t k = 0, g = h >> 32 | 1; k < 4; k++, h += g) {
+        uint64_t b = h & d->bmsk, m = 1ULL << (b & 63);
+        r &= !!(d->blm[b >> 6] & m);
+        if(set) d->blm[b >> 6] |= m;
+    }
+    return r;
+}
+
+static int dupd_spill(dupd_t *d) {
+    uint64_t n = 0;
+    for(uint64_t i = 0; i <= d->tmsk; i++)
+        if(d->tbl[i].pos) d->tbl[n++] = d->tbl[i];
+    qsort(d->tbl, n, sizeof(duprec_t), dupcmp);
+    if(!d->fp && !(d->fp = tmpfile())) {
+        perror("tmpfile");
+        return -1;
+    }
+    uint64_t *p = realloc(d->runs, (d->nrun + 1) * sizeof(uint64_t));
+    if(!p) {
+        perror("realloc");
+        return -1;
+    }
+    d->runs = p; d->runs[d->nrun++] = n;
+    for(uint64_t i = 0; i < n; i++)
+        blm_test(d, duphsh(d->tbl[i].w), 1);
+    if(fwrite(d->tbl, sizeof(duprec_t), n, d->fp) != n) {
+        perror("fwrite");
+        return -1;
+    }
+    memset(d->tbl, 0, (d->tmsk + 1) * sizeof(duprec_t));
+    d->ntbl = 0;
+    return 0;
+}
+
+// a block at time, thus the spilled runs have only whole blocks
+static int dupd_put(dupd_t *d, const archul_t *h, uint32_t size, uint64_t nb) {
+    for(uint32_t n = 0; n < size; n++) {
+        archul_t w = h[n];
+        uint64_t x = duphsh(w), i = x & d->tmsk;
+        for(; d->tbl[i].pos; i = (i + 1) & d->tmsk)
+            if(d->tbl[i].w == w) break;
+        if(d->tbl[i].pos) {
+            if(DUP_BLK(d->tbl[i].pos) != nb) {
+                perr("%u.%u:%u.%u ", (uint32_t)DUP_BLK(d->tbl[i].pos),
+                    (uint32_t)DUP_WRD(d->tbl[i].pos), (uint32_t)nb, n);
+                d->nk++;
+            }
+            continue;
+        }
+        if(d->nrun && blm_test(d, x, 0)) {
+            if(d->ncnd < d->mcnd)
+                d->cnd[d->ncnd++] = (duprec_t){ w, DUP_POS(nb, n) };
+            else d->ovf = 1;
+        }
+        d->tbl[i] = (duprec_t){ w, DUP_POS(nb, n) };
+        d->ntbl++;
+    }
+    return (d->ntbl > (d->tmsk >> 1)) ? dupd_spill(d) : 0;
+}
+
+// verification of the candidates by a single pass on each sorted run
+static void dupd_done(dupd_t *d) {
+    if(!d->fp || !d->ncnd) return;
+    duprec_t buf[1024];
+    qsort(d->cnd, d->ncnd, sizeof(duprec_t), dupcmp);
+    rewind(d->fp);
+    for(uint32_t r = 0; r < d->nrun; r++) {
+        uint64_t left = d->runs[r], c = 0;
+        while(left) {
+            size_t n = fread(buf, sizeof(duprec_t), MIN(left, 1024), d->fp);
+            if(!n) { perror("fread"); return; }
+            left -= n;
+            for(size_t i = 0; i < n; i++) {
+                while(c < d->ncnd && d->cnd[c].w < buf[i].w) c++;
+                for(uint64_t k = c; k < d->ncnd && d->cnd[k].w == buf[i].w; k++) {
+                    // a candidate is spilled as well, later than its first
+                    if(buf[i].pos >= d->cnd[k].pos) continue;
+                    perr("%u.%u:%u.%u ", (uint32_t)DUP_BLK(buf[i].pos),
+                        (uint32_t)DUP_WRD(buf[i].pos),
+                        (uint32_t)DUP_BLK(d->cnd[k].pos),
+                        (uint32_t)DUP_WRD(d->cnd[k].pos));
+                    d->nk++;
+                }
+            }
+        }
+    }
+    if(d->ovf) perr("(run-wide check incomplete, raise -m) ");
+}
+
+/** ENT-LIKE TESTS ************************************************************/
+/*
+ * With -E the analyser also computes, on the output bytes, the same tests of
+ * the ent tool: entropy, chi-square and its p-value, arithmetic mean, Monte
+ * Carlo value of pi and serial correlation. The memory is constant because
+ * they are all running sums. The byte histogram is split into 4 interleaved
+ * sub-histograms, thus close equal bytes do not chain their increments.
+ */
+
+#define ENT_MCN 6                    // bytes for a Monte Carlo point, as ent
+#define ENT_MCR ( (df)((1 << 24) - 1) * ((1 << 24) - 1) ) // radius², 24-bit
+
+typedef struct {
+    uint64_t hst[4][256];            // sub-histograms, added up at the end
+    uint64_t nb, t1, t2, t3;         // bytes, sum u, sum u², sum u[i-1]*u[i]
+    uint64_t mcin, mcnt;             // Monte Carlo points inside and total
+    uint8_t  fst, lst, nmc;          // first and last byte, Monte Carlo bytes
+    uint8_t  mcb[ENT_MCN];
+} entb_t;
+
+static inline __attribute__((always_inline))
+void entblk(entb_t *e, const uint8_t *b, uint32_t n) {
+    uint32_t i = 0;
+    uint64_t t3 = 0;
+    if(!n) return;
+    if(!e->nb) e->fst = b[0]; else t3 = (uint64_t)e->lst * b[0];
+
+    for(; i + 4 <= n; i += 4) {
+        e->hst[0][b[i]]++; e->hst[1][b[i+1]]++;
+        e->hst[2][b[i+2]]++; e->hst[3][b[i+3]]++;
+    }
+    for(; i < n; i++) e->hst[0][b[i]]++;
+    for(i = 1; i < n; i++) t3 += (uint32_t)b[i-1] * b[i];
+    e->t3 += t3; e->lst = b[n-1]; e->nb += n;
+
+    for(i = 0; i < n; i++) {
+        e->mcb[e->nmc++] = b[i];
+        if(e->nmc < ENT_MCN) continue;
+        df x = (df)(e->mcb[0] << 16 | e->mcb[1] << 8 | e->mcb[2]);
+        df y = (df)(e->mcb[3] << 16 | e->mcb[4] << 8 | e->mcb[5]);
+        e->mcin += (x * x + y * y) <= ENT_MCR;
+        e->mcnt++; e->nmc = 0;
+    }
+}
+
+typedef struct {
+    df ent, chi, pchi, mean, pi, scc;
+} entr_t;
+
+static void entres(entb_t *e, entr_t *r) {
+    df n = (df)e->nb;
+    r->ent = 0; r->chi = 0;
+    e->t1 = 0; e->t2 = 0;
+    for(uint32_t c = 0; c < 256; c++) {
+        uint64_t k = e->hst[0][c] + e->hst[1][c] + e->hst[2][c] + e->hst[3][c];
+        df d = (df)k - n / 256;
+        r->chi += d * d / (n / 256);
+        e->t1 += k * c; e->t2 += k * c * c;
+        if(k) r->ent -= (df)k / n * log2((df)k / n);
+    }
+    // chi² upper tail by the Wilson-Hilferty transform, fine with 255 dof
+    df v = 255, z = (cbrt(r->chi / v) - (1 - 2 / (9 * v))) / sqrt(2 / (9 * v));
+    r->pchi = 0.5 * erfc(z / sqrt(2));
+    r->mean = (df)e->t1 / n;
+    r->pi = 4 * (df)e->mcin / MAX(e->mcnt, 1);
+    // the sequence wraps around as in ent, last byte with the first one
+    df t1 = (df)e->t1, t3 = (df)e->t3 + (df)e->lst * e->fst;
+    df den = n * (df)e->t2 - t1 * t1;
+    r->scc = den ? (n * t3 - t1 * t1) / den : 0;
+}
+
+/** ANALYSER ******************************************************************/
+/*
+ * The -T/K/M/G self-evaluation runs in its own thread, fed by main() through
+ * a ring as the workers do, thus the generator does not wait for the stats.
+ * Each word is compared with the AN_WIN words before it, also across blocks,
+ * instead of all the pairs of its block: O(n) rather than O(n²) XORs for the
+ * same Hamming weight and distance estimators. The in-block repetitions are
+ * found by a small open-addressing table, so they are still all reported.
+ */
+
+#define AN_WIN   8                   // power of 2, words compared with each new
+#define AN_HBITS 8                   // in-block table, 256 slots > 128 words
+
+typedef struct {
+    pthread_t tid;
+    ring_t  *rng;
+    uint8_t  nlns;
+    uint32_t min, max;               // Hamming distances, 0 excluded
+    uint64_t bic, nx, nk, nb, nw;    // bits, XORs, duplicates, blocks, words
+    uint64_t lnbc[LNMAX], lnwc[LNMAX];
+    df       avgbc, avgmx, avgmn;    // per block average distance
+    archul_t win[AN_WIN];            // the last AN_WIN words, nw is the head
+    dupd_t  *dd;                     // run-wide duplicates, NULL without -m
+    entb_t  *eb;                     // ent-like tests, NULL without -E
+} anlz_t;
+
+static inline uint32_t anslot(archul_t w) {
+    uint64_t f = (uint64_t)w ^ (uint64_t)(w >> (ABN >> 1));
+    return (uint32_t)((f * 0x9E3779B97F4A7C15ULL) >> (64 - AN_HBITS));
+}
+
+static inline __attribute__((always_inline))
+void anlzblk(anlz_t *a, const archul_t *h, uint32_t size) {
+    uint8_t tbl[1 << AN_HBITS] = { 0 };   // word index + 1, 0 is empty
+    uint64_t avg = 0, nn = 0;
+
+    for(uint32_t n = 0; n < size; n++) {
+        archul_t w = h[n];
+        if(a->nlns > 1) { a->lnbc[n % a->nlns] += popcnt(w); a->lnwc[n % a->nlns]++; }
+
+        for(uint32_t i = anslot(w); ; i = (i + 1) & ((1 << AN_HBITS) - 1)) {
+            if(!tbl[i]) { tbl[i] = n + 1; break; }
+            if(h[tbl[i] - 1] == w) {
+                perr("%u:%u ", tbl[i] - 1, n);
+                a->nk++; break;
+            }
+        }
+
+        uint32_t nwin = MIN(a->nw, AN_WIN);
+        for(uint32_t k = 0; k < nwin; k++) {
+            uint32_t ham = popcnt(w ^ a->win[k]);
+            if(!ham) continue;
+            avg += ham;
+            a->max = MAX(a->max, ham);
+            a->min = MIN(a->min, ham);
+            nn++;
+        }
+        a->win[a->nw++ & (AN_WIN - 1)] = w;
+    }
+    a->bic += avg; a->nx += nn; a->nb++;
+    if(!nn) return;
+
+    df curavg = (df)avg / nn;
+    if(a->avgmx < curavg) a->avgmx = curavg;
+    if(a->avgmn > curavg) a->avgmn = curavg;
+    a->avgbc += curavg;
+}
+
+// the hardware popcount by the same CPUID dispatch of the hot loop
+#define ANLZBLK(name, attr) static attr void anlzblk_##name(anlz_t *a,\
+    const archul_t *h, uint32_t size) { anlzblk(a, h, size); }
+
+ANLZBLK(base, )
+#ifdef __x86_64__
+ANLZBLK(x86v2, __attribute__((target("popcnt,sse4.2"))))
+ANLZBLK(x86v3, __attribute__((target("popcnt,sse4.2,avx,avx2,bmi,bmi2"))))
+#endif
+
+static void (*const anlzvars[])(anlz_t *, const archul_t *, uint32_t) = {
+    anlzblk_base,
+#ifdef __x86_64__
+    anlzblk_x86v2, anlzblk_x86v3,
+#endif
+};
+
+// a zero-sized block is the end of the run
+static void *analyser(void *arg) {
+    anlz_t *a = (anlz_t *)arg;
+    void (*blk)(anlz_t *, const archul_t *, uint32_t) =
+        anlzvars[djb2tum_dispatch()];
+
+    for(;;) {
+        uint32_t size;
+        block512_t *bp = ring_rget(a->rng, &size);
+        if(size) blk(a, bp->dt, size);
+        if(size && a->dd && dupd_put(a->dd, bp->dt, size, a->nb - 1))
+            exit(EXIT_FAILURE);
+        if(size && a->eb) entblk(a->eb, bp->uc, size << ABL);
+        ring_rput(a->rng);
+        if(!size) break;
+    }
+    return NULL;
+}
+
+static int anlz_start(anlz_t *a, uint8_t nlns, uint32_t dupmb, uint8_t entt) {
+    memset(a, 0, sizeof(*a));
+    a->nlns = nlns; a->min = ABN; a->avgmn = ABN;
+    if((dupmb && !(a->dd = dupd_init(dupmb)))
+    || (entt && !(a->eb = calloc(1, sizeof(entb_t))))) {
+        perror("calloc");
+        return -1;
+    }
+    if (posix_memalign((void **)&a->rng, ALGN, sizeof(ring_t)) || !a->rng) {
+        perror("posix_memalign");
+        return -1;
+    }
+    memset(a->rng, 0, sizeof(ring_t));
+    errno = pthread_create(&a->tid, NULL, analyser, a);
+    if(errno) {
+        perror("pthread_create");
+        return -1;
+    }
+    return 0;
+}
+
+static inline void anlz_push(anlz_t *a, const archul_t *h, uint32_t size) {
+    block512_t *bp = ring_wget(a->rng);
+    if(size) memcpy(bp->dt, h, size << ABL);
+    ring_wput(a->rng, size);
+}
+
+static void anlz_stop(anlz_t *a) {
+    anlz_push(a, NULL, 0);
+    pthread_join(a->tid, NULL);
+    if(!a->dd) return;
+    dupd_done(a->dd);
+    a->nk += a->dd->nk;
+}
+
+/** PROBES BENCHMARK **********************************************************/
+/*
+ * Each probe runs between two clock reads as in djb2tum(), the latencies dlt
+ * and the jitters dff (dlt - dmn) have the same meaning of the final report.
+ * The bits for sample are the Shannon and the min-entropy of the dlt's 8 LSB:
+ * the cheapest probe that still shows some of them is the one to use.
+ */
+
+#define BP_SAMPLES 4096
+
+static void bench_probes(uint8_t nbtls) {
+    static uint32_t dlt[BP_SAMPLES];
+
+    perr("\nClock  ns/call  res:ns  ticks/us\n");
+    for(clksrc_t *c = clksrcs; c->name; c++) {
+        if(!c->avail) { perr("%-6s n/a\n", c->name); continue; }
+        clkcalib(c);
+        perr("%-6s %7u %7u %9u%s\n", c->name, c->cost, c->res, c->tpus,
+            (c == clksrc) ? " <" : "");
+    }
+
+    perr("\nProbe  ns/smp      dmn      dmx      jmn      jmx     javg  H:bits  Hmin\n");
+    for(const jprobe_t *p = jprobes; p->name; p++) {
+        if(djb2tum_probe(p->name)) { perr("%-6s n/a\n", p->name); continue; }
+
+        uint32_t a, n = 0, hst[256] = { 0 }, hmx = 0;
+        uint64_t dmn = -1, dmx = 0, jmn = -1, jmx = 0, javg = 0, nj = 0;
+        for(a = 64; a; a--) jprobe();                 // warm-up: caches, peers
+
+        uint64_t st = get_nanos();
+        uint32_t t, o = getnstime(NULL);
+        for(a = BP_SAMPLES; a; a--) {
+            jprobe();
+            t = getnstime(NULL);
+            uint32_t d = (t - o) >> nbtls; o = t;
+            if(dtskew(d)) continue;
+            dlt[n++] = d;
+            dmn = MIN(dmn, d); dmx = MAX(dmx, d);
+        }
+        uint64_t et = get_nanos() - st;
+
+        df hs = 0, hm = 0;
+        for(a = 0; a < n; a++) {
+            uint64_t dff = dlt[a] - dmn;
+            hst[dlt[a] & 0xFF]++;
+            if(!dff) continue;
+            jmn = MIN(jmn, dff); jmx = MAX(jmx, dff);
+            javg += dff; nj++;
+        }
+        for(a = 0; a < 256; a++) {
+            if(!hst[a]) continue;
+            df pa = (df)hst[a] / n;
+            hs -= pa * log2(pa);
+            hmx = MAX(hmx, hst[a]);
+        }
+        if(n) hm = -log2((df)hmx / n);
+        if(!nj) jmn = 0;
+
+        perr("%-6s %6.0lf %8.0lf %8.0lf %8.0lf %8.0lf %8.1lf %7.3lf %5.3lf\n",
+            p->name, (df)et / BP_SAMPLES, (df)(n ? dmn : 0), (df)dmx, (df)jmn,
+            (df)jmx, nj ? (df)javg / nj : 0, hs, hm);
+    }
+    perr("\n");
+}
+
 static inline void usage(const char *name, const char *cmdn, const uint8_t qlvl) {
     perr("\n"\
 "%s "VERSION" reads from stdin, stats on stderr, and rand on stdout.\n"\
 "|\n"\
-"\\_ Usage: %s [-h,q%s,V] [-T/K/M/G N] [-d,p,s,r N] [-k /dev/rnd]\n"\
+"\\_ Usage: %s [-h,q%s,V,B,C,E] [-T/K/M/G N] [-d,p,s,r,j,l,m,e,A,f,X,x N] [-P prb] [-c clk] [-k /dev/rnd]\n"\
 " |\n"\
 " |    -qq,-q: (extra) quiet run for scripts automation\n"\
 " |    -K/-M/-G: kilo/mega/giga bytes of data w/ stats on\n"\
 " |    -S: low-entropy VMs seeding settings (r31,d3,i16,K4)\n"\
 " |    -Z: the same as -S but with a reset at 2^19 bytes\n"\
+" |    -B: boot profile: mlock, early 256 bits to -k, phases\n"\
 " |    -T: number of collision tests x2 on the same input\n"\
-" |    -d: number of ns above min as the minimum delay\n"\
-" |    -p: number of parts as min/256 ns above the min\n"\
+" |    -d: ns (tsc: ticks) above the min as minimum delay\n"\
+" |    -p: number of parts as min/256 above the min\n"\
 " |    -s: number of bits to left shift on ns timings\n"\
 " |    -r: number of preliminary runs (default: 1)\n"\
+" |    -A: ms of autotune for the -s,d,p,r preset to use\n"\
 " |    -k: randomness injection in kernel by ioctl\n"\
+" |    -e: max bits/byte credited by -k (default: 7)\n"\
+" |    -f: feed -k on demand, polling its pool every N ms\n"\
+" |    -X: chacha20 expanded output, reseed every N KB\n"\
+" |    -x: also reseed the -X expansion every N ms\n"\
 " |    -i: number of 512B-blocks to read from stdin\n"\
+" |    -C: conditioner of an endless binary stream on stdin\n"\
+" |    -j: number of pinned threads, output merged in order\n"\
+" |    -l: number of hash lanes fed by each timing sample\n"\
+" |    -m: MB for the run-wide repetitions check, disk spill\n"\
+" |    -E: ent-like tests of the output bytes, w/ stats on\n"\
+" |    -P: jitter probe: yield, sleep, pause, chase, futex, none\n"\
+" |    -c: clock: auto (POSIX ones), mono, mraw, boot, tsc, cntv\n"\
+" |    --bench-probes: ns and bits for sample of each probe\n"\
+" |    --capture FILE: raw samples into a mmap'd ring of 1M\n"\
+" |    --replay FILE|synth: capture as clock, output digest\n"\
+" |    --hist[=FILE]: p50..p99.9 of dlt/dff/reschedules, CSV\n"\
+" |    --serve SOCKET: warm pool for the clients of a socket\n"\
+" |    --state FILE: warm state loaded at start, saved at exit\n"\
 " |    -h/-v: shows this help / appname and version\n"\
 " |\n "\
 "\\_ With -pN is suggested -r31 or -r63 for stats pre-evaluation.\n"\
@@ -790,34 +2220,819 @@ static inline void usage(const char *name, const char *cmdn, const uint8_t qlvl)
     return;
 }
 
-#define APPNAME "uChaos"
+#define OPT_BPRB 0x100
+#define OPT_CAPT 0x101
+#define OPT_RPLY 0x102
+#define OPT_HIST 0x103
+#define OPT_SERV 0x104
+#define OPT_STAT 0x105
+#define CAP_NBITS 20                 // 1M records, 32MB of capture ring
+
+static const struct option lopts[] = {
+    { "bench-probes", no_argument, NULL, OPT_BPRB },
+    { "capture", required_argument, NULL, OPT_CAPT },
+    { "replay",  required_argument, NULL, OPT_RPLY },
+    { "hist",    optional_argument, NULL, OPT_HIST },
+    { "serve",   required_argument, NULL, OPT_SERV },
+    { "state",   required_argument, NULL, OPT_STAT },
+    { NULL, 0, NULL, 0 }
+};
 #define STCX STOCHASTIC_BRANCHES
-#define perrprms(s,p) perr("%s s:%u, q:%u, d+p(%u):%u+%u ns, r:%u, i:%u, Z:%u\n\n",\
-                      s, nbtls, quiet, pmdly, nsdly, p?p:1, nrdry, nblks, rset)
 
-typedef double __attribute__((aligned(8))) df;
+// credits ecnt bits to the kernel by the first sz bytes of buf, -1 on error
+static int rndaddentropy(int fd, const uint8_t *buf, uint32_t sz, uint32_t ecnt) {
+    struct rand_pool_info_buf entrnd;
+    entrnd.buf_size = sz;
+    entrnd.entropy_count = ecnt;
+    memcpy((uint8_t *)entrnd.buf, buf, sz);
+    if (ioctl(fd, RNDADDENTROPY, &entrnd) < 0 && errno != EINTR) {
+        if(errno == ENOTTY) {
+          perr("\nERROR: "APPNAME" "OPTNK"\n\n");
+        } else perror("ioctl entrnd");
+        return -1;
+    }
+    return 0;
+}
+
+// fail closed: the caller stops the output and the crediting, then exits
+static int hltfail(uint32_t fl) {
+    perr("\nERROR: "APPNAME" health test failed:%s%s%s%s, output stopped\n\n",
+        (fl & HLT_RCT_DLT) ? " RCT dlt" : "", (fl & HLT_APT_DLT) ? " APT dlt" : "",
+        (fl & HLT_RCT_DFF) ? " RCT dff" : "", (fl & HLT_APT_DFF) ? " APT dff" : "");
+    return EXIT_FAILURE;
+}
+
+/** HISTOGRAMS ****************************************************************/
+/*
+ * With --hist the contexts count every dlt and dff, and the reschedules for
+ * each word, in log-linear buckets: one increment in the hot loop. The report
+ * has their percentiles, the tails tell when the scheduler limits the speed
+ * rather than the hash. With --hist=FILE, all the buckets also go in a CSV.
+ */
+
+static const double hdrq[] = { 0.5, 0.9, 0.99, 0.999 };
+
+static void hdr_report(const djb2hdr_t *h) {
+    const char *nm[] = { "dlt", "dff", "rsc" };
+    const uint64_t *v[] = { h->dlt, h->dff, h->rsc };
+    for(uint32_t i = 0; i < 3; i++) {
+        perr("%sHistos %s:", i ? "`" : "", nm[i]);
+        for(uint32_t q = 0; q < sizeof(hdrq) / sizeof(*hdrq); q++)
+            perr(" p%g %.0lf%s", hdrq[q] * 100, (df)djb2hdr_quantile(v[i], hdrq[q]),
+                (q + 1 < sizeof(hdrq) / sizeof(*hdrq)) ? "," : "");
+        perr(" %s\n", i < 2 ? clkunit() : "for word");
+    }
+}
+
+static int hdr_csv(const djb2hdr_t *h, const char *path) {
+    FILE *fp = fopen(path, "w");
+    if(!fp) {
+        perror("fopen");
+        return -1;
+    }
+    fprintf(fp, "bucket,floor,dlt,dff,rsc\n");
+    for(uint32_t b = 0; b < HDR_NBKT; b++) {
+        if(!h->dlt[b] && !h->dff[b] && !h->rsc[b]) continue;
+        fprintf(fp, "%u,%llu,%llu,%llu,%llu\n", b,
+            (unsigned long long)djb2hdr_value(b), (unsigned long long)h->dlt[b],
+            (unsigned long long)h->dff[b], (unsigned long long)h->rsc[b]);
+    }
+    return fclose(fp);
+}
+
+#ifdef _USE_PROFILING
+static const char *prfnm[PRF_NSTG] = { "0.prepare", "1.time", "2.latency",
+    "3.state", "4.jitter", "5.distill", "6.macromix", "7.inject", "8.next",
+    "8.reschedule", "8.probe", "9.finalise" };
+static const char *prgnm[PRG_NGTO] = { "reschedule", "notcrashstats",
+    "skiptoetropy", "hashotloop" };
+
+// at the exit: the threads not yet ended are not in the totals
+static void prf_report(void) {
+    uint64_t tck = -1, tot = 0;
+    djb2prf_fold();
+    for(uint32_t i = 0; i < 64; i++) {   // the cost of a counter read
+        uint64_t t = prftick(); tck = MIN(tck, prftick() - t);
+    }
+    for(uint32_t i = 0; i < PRF_NSTG; i++) tot += prfg.cyc[i];
+    if(!tot) return;
+    perr("\nProfile: %s ticks, %.0lf for each read\n",
+        HAS_RDTSC ? "tsc" : (HAS_CNTVCT ? "cntv" : "ns"), (df)tck);
+    perr("  %-13s %13s %12s %8s %6s\n", "stage", "ticks", "count", "avg", "%");
+    for(uint32_t i = 0; i < PRF_NSTG; i++)
+        perr("  %-13s %13.0lf %12.0lf %8.1lf %5.1lf%%\n", prfnm[i],
+            (df)prfg.cyc[i], (df)prfg.cnt[i],
+            prfg.cnt[i] ? (df)prfg.cyc[i] / prfg.cnt[i] : 0, (df)prfg.cyc[i] * 100 / tot);
+    perr("  %-13s %13s %12s\n", "goto", "taken", "/sample");
+    for(uint32_t i = 0; i < PRG_NGTO; i++)
+        perr("  %-13s %13.0lf %12.3lf\n", prgnm[i], (df)prfg.gto[i],
+            prfg.cnt[PRF_TIME] ? (df)prfg.gto[i] / prfg.cnt[PRF_TIME] : 0);
+}
+#endif
+
+/** AUTOTUNE ******************************************************************/
+/*
+ * With -A ms the budget is split among a grid of -s/-d/-p settings, each one
+ * hashing the input on a fresh context for its slice of time. A setting is
+ * eligible when the health tests pass, the exceptions are at most AT_MAXEXP,
+ * the min-entropy is at least AT_MINHMN bits for sample and the jitter floor
+ * (-d plus the -p parts of the min) is at least AT_MINJIT: the fastest one in
+ * KH/s wins. Then -r is the number of blocks its min latency took to settle,
+ * rounded up as 2^n-1. The chosen preset is printed and used for the run.
+ */
+
+#define AT_MAXEXP  25                // % of exceptions on the samples
+#define AT_MINHMN  256               // 1/256 bits for sample, thus 1 bit
+#define AT_MINJIT  3                 // ticks, as the -S preset d3
+
+static const uint8_t atgs[] = { 0, 1, 2, 3 }, atgd[] = { 0, 1, 3, 5 },
+                     atgp[] = { 0, 1, 3 };
+
+typedef struct {
+    uint8_t  s, r;
+    uint32_t d, p;
+    df       khs, exp, hmn, jit;
+} atres_t;
+
+static void autotune_run(atres_t *a, const uint8_t *str, uint32_t n, uint64_t ns) {
+    djb2_t ctx;
+    archul_t h[BLOCK_SIZE >> ABL];
+    uint64_t nw = 0, dmn = -1, st = get_nanos(), nb = 0, lb = 0;
+    uint32_t pmdly = a->p;
+
+    djb2tum_init(&ctx);
+    while(get_nanos() - st < ns) {
+        uint32_t size = n;
+        str2hsh(&ctx, str, h, &size, a->d, a->p, a->s, 0);
+        nw += size; nb++;
+        if(ctx.dmn != dmn) { dmn = ctx.dmn; lb = nb; }
+    }
+    ns = get_nanos() - st;
+    a->khs = (df)nw * E6 / MAX(ns, 1);
+    a->exp = (df)ctx.nexp * 100 / MAX(ctx.ctot, 1);
+    a->hmn = djb2tum_health(&ctx) ? 0 : (df)djb2tum_hmin(&ctx) / 256;
+    a->jit = a->d + (a->p ? PMDLY2NS(ctx.dmn) : 1);
+    for(a->r = 1; a->r < lb && a->r < 63; a->r = (a->r << 1) | 1);
+}
+
+static int autotune(const uint8_t *str, uint32_t n, uint32_t ms, uint8_t *nbtls,
+    uint32_t *nsdly, uint32_t *pmdly, uint32_t *nrdry, uint8_t quiet)
+{
+    const uint32_t ns = sizeof(atgs), nd = sizeof(atgd), np = sizeof(atgp);
+    uint64_t slice = (uint64_t)ms * E6 / (ns * nd * np);
+    atres_t a, best = { 0 };
+
+    if(!quiet) perr("\nAutotune: %u settings, %.3lgms each, targets ex<=%u%% "
+        "hmin>=%.1lfb jit>=%u\n", ns * nd * np, (df)slice / E6, AT_MAXEXP,
+        (df)AT_MINHMN / 256, AT_MINJIT);
+    for(uint32_t i = 0; i < ns * nd * np; i++) {
+        a = (atres_t){ atgs[i / (nd * np)], 0, atgd[i / np % nd], atgp[i % np],
+            0, 0, 0, 0 };
+        autotune_run(&a, str, n, slice);
+        uint8_t ok = a.exp <= AT_MAXEXP && a.hmn * 256 >= AT_MINHMN
+                  && a.jit >= AT_MINJIT;
+        if(quiet < 1) perr("  -s %u -d %u -p %u: %8.1lf KH/s, ex:%6.2lf%%, "
+            "hmin %.2lfb, jit %.0lf%s\n", a.s, a.d, a.p, a.khs, a.exp, a.hmn,
+            a.jit, ok ? "" : " x");
+        if(ok && a.khs > best.khs) best = a;
+    }
+    if(!best.khs) {
+        perr("\nERROR: "APPNAME" autotune, no settings within the targets\n\n");
+        return -1;
+    }
+    *nbtls = best.s; *nsdly = best.d; *pmdly = best.p; *nrdry = best.r;
+    if(quiet < 2) perr("Preset: -s%u -d%u -p%u -r%u, %.1lf KH/s, ex:%.2lf%%, "
+        "hmin %.2lfb\n", best.s, best.d, best.p, best.r, best.khs, best.exp,
+        best.hmn);
+    return 0;
+}
+
+#define perrcrd(c,b,s) perr("Credits: %.3lf bits/byte over %.0lf bytes, "\
+    "min-entropy %.3lf bits/sample\n\n", (df)(c) / MAX(b, 1), (df)(b),\
+    (df)djb2tum_hmin(s) / 256)
+
+// SIGINT and SIGTERM with -f, --serve or --state: the run ends as at its end
+static volatile sig_atomic_t fdstop = 0;
+static void fdsignal(int sig) { fdstop = sig; }
+
+/** CONDITIONER ***************************************************************/
+/*
+ * With -C the input is an endless binary stream, e.g. /dev/urandom or a sensor
+ * feed: a thread reads it by blocks, the main thread hashes each input word by
+ * a djb2tum() call, and another thread writes the words out. The three stages
+ * are chained by bounded rings, thus the memory is fixed whatever the input is
+ * and the reading or writing latency does not stall the hashing. A zero-sized
+ * block is the end of the stream, and the input is binary safe (no \0 ending).
+ * The signals go to the reader only, thus a stop by --state interrupts a read
+ * on an endless stdin, and the end flows through the rings as an EOF does.
+ */
+
+typedef struct {
+    ring_t *rng;
+    int fd;
+    uint8_t quiet;
+    uint64_t nbytes, ncrd;
+} cndtn_t;
+
+static void *cndtn_reader(void *arg) {
+    cndtn_t *c = (cndtn_t *)arg;
+    sigset_t ss;
+    sigemptyset(&ss); sigaddset(&ss, SIGINT); sigaddset(&ss, SIGTERM);
+    pthread_sigmask(SIG_UNBLOCK, &ss, NULL);
+    while(1) {
+        block512_t *bp = ring_wget(c->rng);
+        uint32_t n = fdstop ? 0 : readbuf(c->fd, bp->uc, BLOCK_SIZE, 1);
+        if(n < BLOCK_SIZE) memset(&bp->uc[n], 0, BLOCK_SIZE - n);
+        ring_wput(c->rng, n);
+        c->nbytes += n;
+        if(!n) break;
+    }
+    return NULL;
+}
+
+static void *cndtn_writer(void *arg) {
+    cndtn_t *c = (cndtn_t *)arg;
+    uint32_t sz;
+    while(1) {
+        block512_t *bp = ring_rget(c->rng, &sz);
+        if(!sz) break;
+        if(c->fd) {
+            uint32_t crd = ring_rcrd(c->rng);
+            if(rndaddentropy(c->fd, bp->uc, sz, crd)) exit(EXIT_FAILURE);
+            c->ncrd += crd;
+            if(c->quiet < 2) writebuf(STDOUT_FILENO, bp->uc, sz);
+        } else  writebuf(STDOUT_FILENO, bp->uc, sz);
+        c->nbytes += sz;
+        ring_rput(c->rng);
+    }
+    return NULL;
+}
+
+static int conditioner(djb2_t *ctx, int devfd, uint32_t nrdry, uint32_t nsdly,
+    uint32_t pmdly, uint8_t nbtls, uint8_t quiet, uint8_t ecap)
+{
+    cndtn_t rd = { NULL, STDIN_FILENO, quiet, 0, 0 };
+    cndtn_t wr = { NULL, devfd, quiet, 0, 0 };
+    pthread_t rdt, wrt;
+    uint32_t n, size, nb = 0;
+
+    if (posix_memalign((void **)&rd.rng, ALGN, sizeof(ring_t)) || !rd.rng
+    ||  posix_memalign((void **)&wr.rng, ALGN, sizeof(ring_t)) || !wr.rng) {
+        perror("posix_memalign");
+        return EXIT_FAILURE;
+    }
+    memset(rd.rng, 0, sizeof(ring_t));
+    memset(wr.rng, 0, sizeof(ring_t));
+    sigset_t ss;                     // inherited by the writer, not the reader
+    sigemptyset(&ss); sigaddset(&ss, SIGINT); sigaddset(&ss, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &ss, NULL);
+    if ((errno = pthread_create(&rdt, NULL, cndtn_reader, &rd))
+    ||  (errno = pthread_create(&wrt, NULL, cndtn_writer, &wr))) {
+        perror("pthread_create");
+        return EXIT_FAILURE;
+    }
+
+    uint64_t mt = 0, st = get_nanos();
+    while(1) {
+        block512_t *in = ring_rget(rd.rng, &n);
+        block512_t *ot = ring_wget(wr.rng);
+        if(n) {
+            for(uint32_t a = nb++ ? 0 : nrdry; a; a--) {
+                size = n;                // the first block for the dry runs
+                str2hsh(ctx, in->uc, ot->dt, &size, nsdly, pmdly, nbtls, 0);
+            }
+            uint64_t stns = get_nanos(), ctot = ctx->ctot;
+            size = n;
+            str2hsh(ctx, in->uc, ot->dt, &size, nsdly, pmdly, nbtls, 0);
+            mt += get_nanos() - stns;
+            n = djb2tum_health(ctx) ? 0 : size << ABL;
+            ring_wcrd(wr.rng, djb2credit(ctx, ctx->ctot - ctot, n, ecap));
+        }
+        ring_rput(rd.rng);
+        ring_wput(wr.rng, n);
+        if(!n) break;
+    }
+    pthread_join(wrt, NULL);         // it drains up to the zero-sized block
+    // fail closed: the reader can be blocked on the full ring or on an endless
+    // stdin, thus it is not joined, the exit ends it
+    if(djb2tum_health(ctx)) return hltfail(djb2tum_health(ctx));
+    pthread_join(rdt, NULL);
+
+    uint64_t rt = get_nanos() - st;
+    if(quiet) return 0;
+    perr_app_info(0);
+    perr("; conditioner: in %.3lfMB, out %.3lfMB\n", (df)rd.nbytes / (1 << 20),
+        (df)wr.nbytes / (1 << 20));
+    perr("Perform: exec %.3lgs, %.3lg MB/s; hash %.3lgs, %.01lf KH/s\n\n",
+        (df)rt/E9, (df)wr.nbytes * E3 / MAX(rt, 1), (df)mt/E9,
+        (df)(E9>>10) * (wr.nbytes >> ABL) / MAX(mt, 1));
+    if(devfd) perrcrd(wr.ncrd, wr.nbytes, ctx);
+    return 0;
+}
+/** FEEDER ********************************************************************/
+/*
+ * With -f the -k injection is on demand: the process sleeps in poll() on the
+ * random device and wakes up by POLLOUT, or every -f ms because the kernels
+ * since 5.18 signal POLLOUT only until the crng is ready. Then it hashes only
+ * the blocks needed to fill the pool as entropy_avail tells, and it injects
+ * them in a batch. The avail before and after tell how many of the credited
+ * bits the kernel accounted: the efficiency, in the log of each batch.
+ */
+
+#define FD_MAXB   8                  // max blocks in a batch, 4KB
+#define FD_PROC "/proc/sys/kernel/random/"
+
+// the integer in the proc file at path, -1 on error
+static long rdprocl(const char *path) {
+    char buf[32];
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return -1;
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if(n <= 0) return -1;
+    buf[n] = 0;
+    return atol(buf);
+}
+
+static int feeder(djb2_t *ctx, const uint8_t *str, uint32_t n, int devfd,
+    uint32_t nsdly, uint32_t pmdly, uint8_t nbtls, uint8_t quiet, uint8_t ecap,
+    uint32_t ms)
+{
+    archul_t *hsh = NULL;
+    long pool = rdprocl(FD_PROC "poolsize");
+    long wkup = rdprocl(FD_PROC "write_wakeup_threshold");
+    uint64_t nwak = 0, nbtc = 0, nblk = 0, ncrd = 0, ngot = 0, ntmo = 0;
+    struct sigaction sa = { .sa_handler = fdsignal };   // no SA_RESTART
+
+    if(pool < 0 || rdprocl(FD_PROC "entropy_avail") < 0) {
+        perror("open " FD_PROC "entropy_avail");
+        return EXIT_FAILURE;
+    }
+    if (posix_memalign((void **)&hsh, ALGN, FD_MAXB * BLOCK_SIZE) || !hsh) {
+        perror("posix_memalign");
+        return EXIT_FAILURE;
+    }
+    if(wkup <= 0 || wkup > pool) wkup = pool;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    if(quiet < 2) {
+        perr_app_info(0);
+        perr("; feeder: pool %ld bits, wakeup below %ld, poll %ums\n\n",
+            pool, wkup, ms);
+    }
+
+    struct pollfd pfd = { devfd, POLLOUT, 0 };
+    while(!fdstop) {
+        int rc = poll(&pfd, 1, ms ? (int)ms : -1);
+        if(rc < 0 && errno != EINTR) {
+            perror("poll");
+            return EXIT_FAILURE;
+        }
+        if(rc <= 0) { ntmo += !rc; if(rc < 0) continue; }
+        nwak++;
+        long a0 = rdprocl(FD_PROC "entropy_avail");
+        if(a0 < 0 || a0 >= wkup) continue;
+
+        // the blocks to fill the pool up, by the credits they get
+        uint32_t nb = 0, crd[FD_MAXB];
+        for(long need = pool - a0; need > 0 && nb < FD_MAXB; nb++) {
+            uint32_t size = n;
+            uint64_t ctot = ctx->ctot;
+            str2hsh(ctx, str, &hsh[nb * (BLOCK_SIZE >> ABL)], &size, nsdly,
+                pmdly, nbtls, 0);
+            if(djb2tum_health(ctx)) return hltfail(djb2tum_health(ctx));
+            crd[nb] = djb2credit(ctx, ctx->ctot - ctot, size << ABL, ecap);
+            need -= crd[nb];
+        }
+        uint32_t bc = 0;
+        for(uint32_t b = 0; b < nb; b++) {
+            if(rndaddentropy(devfd, (uint8_t *)&hsh[b * (BLOCK_SIZE >> ABL)],
+                ((n + ABz) >> ABL) << ABL, crd[b]))
+                return EXIT_FAILURE;
+            bc += crd[b];
+        }
+        long a1 = rdprocl(FD_PROC "entropy_avail");
+        long got = MAX(0, a1 - a0);
+        nbtc++; nblk += nb; ncrd += bc; ngot += got;
+        if(!quiet)
+            perr("Feed: avail %ld -> %ld bits, credited %u by %u blocks, "
+                "efficiency %.1lf%%\n", a0, a1, bc, nb, (df)got * 100 / MAX(bc, 1));
+    }
+
+    free(hsh);
+    if(quiet < 2)
+        perr("\nFeeder: %.0lf wakeups (%.0lf by timeout), %.0lf batches of "
+            "%.0lf blocks, credited %.0lf bits, accounted %.0lf (%.1lf%%)\n\n",
+            (df)nwak, (df)ntmo, (df)nbtc, (df)nblk, (df)ncrd, (df)ngot,
+            (df)ngot * 100 / MAX(ncrd, 1));
+    return 0;
+}
+
+/** SERVER ********************************************************************/
+/*
+ * With --serve SOCKET the process keeps its warm context, after the dry runs,
+ * and a pool of output between the low and the high watermarks, refilled when
+ * the clients are idle. A client writes a 4 bytes length (host order, up to
+ * SV_MAXREQ) and it reads that many bytes back: a memcpy out of the pool, the
+ * hashing is on the request path only when the pool is short (a miss). The
+ * counters of each client are logged when it closes, and the totals at exit.
+ */
+
+#define SV_POOL  (1 << 20)           // pool size, it is the high watermark
+#define SV_LOW   (SV_POOL >> 2)      // the refill is urgent below it
+#define SV_MAXREQ (1 << 16)          // max bytes for each request
+#define SV_MAXC   64                 // max concurrent clients
+#define SV_FILL   16                 // blocks hashed between two epoll_wait
+
+typedef struct {
+    int fd;
+    uint32_t nhdr, len, off;         // request header bytes, reply len, sent
+    uint8_t hdr[4], *out;            // the reply in flight, SV_MAXREQ
+    uint64_t nreq, nbytes, nmiss, lat, lmx, st, rqt;
+} svcl_t;
+
+typedef struct {
+    djb2_t *ctx;
+    const uint8_t *str;
+    archul_t *hsh;
+    uint8_t *pool;
+    uint64_t head, tail;             // bytes ever put in and taken out
+    uint32_t n, nsdly, pmdly;
+    uint8_t nbtls;
+} svpl_t;
+
+// one block more in the pool, -1 on health test failure
+static int svfill(svpl_t *p) {
+    uint32_t size = p->n;
+    str2hsh(p->ctx, p->str, p->hsh, &size, p->nsdly, p->pmdly, p->nbtls, 0);
+    if(djb2tum_health(p->ctx)) return -1;
+    uint32_t sz = size << ABL, h = p->head % SV_POOL, k = MIN(sz, SV_POOL - h);
+    memcpy(&p->pool[h], p->hsh, k);
+    memcpy(p->pool, (uint8_t *)p->hsh + k, sz - k);
+    p->head += sz;
+    return 0;
+}
+
+static void svtake(svpl_t *p, uint8_t *dst, uint32_t len) {
+    uint32_t t = p->tail % SV_POOL, k = MIN(len, SV_POOL - t);
+    memcpy(dst, &p->pool[t], k);
+    memcpy(dst + k, p->pool, len - k);
+    p->tail += len;
+}
+
+static void svclose(int ep, svcl_t *c, uint8_t quiet) {
+    epoll_ctl(ep, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    if(quiet < 1)
+        perr("Client %d: %.0lf requests, %.0lf bytes, %.0lf misses, latency "
+            "avg %.3lf max %.3lf us, %.3lfs\n", c->fd, (df)c->nreq, (df)c->nbytes,
+            (df)c->nmiss, (df)c->lat / MAX(c->nreq, 1) / E3, (df)c->lmx / E3,
+            (df)(get_nanos() - c->st) / E9);
+    c->fd = -1;
+}
+
+// sends what the socket takes of the reply in flight, -1 on error
+static int svsend(svcl_t *c) {
+    while(c->off < c->len) {
+        ssize_t nw = write(c->fd, c->out + c->off, c->len - c->off);
+        if(nw < 0 && errno == EINTR) continue;
+        if(nw < 0 && errno == EAGAIN) return 0;
+        if(nw < 1) return -1;
+        c->off += nw;
+    }
+    uint64_t lt = get_nanos() - c->rqt;
+    c->lat += lt; c->lmx = MAX(c->lmx, lt);
+    c->len = c->off = 0;
+    return 0;
+}
+
+static int server(djb2_t *ctx, const uint8_t *str, uint32_t n, const char *path,
+    uint32_t nsdly, uint32_t pmdly, uint8_t nbtls, uint8_t quiet)
+{
+    svpl_t pl = { ctx, str, NULL, NULL, 0, 0, n, nsdly, pmdly, nbtls };
+    svcl_t *cl = calloc(SV_MAXC, sizeof(svcl_t));
+    struct sockaddr_un sa = { .sun_family = AF_UNIX };
+    struct sigaction sg = { .sa_handler = fdsignal };
+    struct epoll_event ev, evs[SV_MAXC + 1];
+    uint64_t ncl = 0, nbytes = 0, nmiss = 0, nreq = 0, st = get_nanos();
+
+    if(!cl || posix_memalign((void **)&pl.hsh, ALGN, BLOCK_SIZE) || !pl.hsh
+    ||  posix_memalign((void **)&pl.pool, ALGN, SV_POOL) || !pl.pool) {
+        perror("posix_memalign");
+        return EXIT_FAILURE;
+    }
+    if(strlen(path) >= sizeof(sa.sun_path)) {
+        perr("\nERROR: "APPNAME" socket path too long: %s\n\n", path);
+        return EXIT_FAILURE;
+    }
+    strcpy(sa.sun_path, path);
+    unlink(path);
+    int ls = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    if(ls < 0 || ep < 0 || bind(ls, (struct sockaddr *)&sa, sizeof(sa))
+    || listen(ls, SV_MAXC)) {
+        perror("socket");
+        return EXIT_FAILURE;
+    }
+    ev.events = EPOLLIN; ev.data.u32 = SV_MAXC;      // the listener
+    epoll_ctl(ep, EPOLL_CTL_ADD, ls, &ev);
+    for(uint32_t i = 0; i < SV_MAXC; i++) cl[i].fd = -1;
+    sigaction(SIGINT, &sg, NULL);
+    sigaction(SIGTERM, &sg, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    while(pl.head < SV_POOL - BLOCK_SIZE)            // prefilled, then served
+        if(svfill(&pl)) return hltfail(djb2tum_health(ctx));
+    if(quiet < 2) {
+        perr_app_info(0);
+        perr("; server: %s, pool %uKB (low %uKB), max %u clients\n\n", path,
+            SV_POOL >> 10, SV_LOW >> 10, SV_MAXC);
+    }
+
+    while(!fdstop) {
+        // idle and below the high watermark: refilling, else waiting
+        uint32_t lvl = pl.head - pl.tail;
+        int ne = epoll_wait(ep, evs, SV_MAXC + 1,
+            (lvl < SV_POOL - BLOCK_SIZE) ? 0 : -1);
+        if(ne < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            return EXIT_FAILURE;
+        }
+        for(int e = 0; e < ne; e++) {
+            uint32_t i = evs[e].data.u32;
+            if(i == SV_MAXC) {                           // new clients
+                int fd;
+                while((fd = accept4(ls, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    for(i = 0; i < SV_MAXC && cl[i].fd >= 0; i++);
+                    if(i == SV_MAXC) { close(fd); continue; }
+                    uint8_t *out = cl[i].out;
+                    memset(&cl[i], 0, sizeof(svcl_t));
+                    cl[i].fd = fd; cl[i].st = get_nanos(); cl[i].out = out;
+                    if(!out && !(cl[i].out = malloc(SV_MAXREQ))) {
+                        perror("malloc");
+                        return EXIT_FAILURE;
+                    }
+                    ev.events = EPOLLIN | EPOLLOUT | EPOLLET; ev.data.u32 = i;
+                    epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+                    ncl++;
+                }
+                continue;
+            }
+            svcl_t *c = &cl[i];
+            if(c->fd < 0) continue;
+            int err = !!(evs[e].events & (EPOLLERR | EPOLLHUP));
+            while(!err) {
+                if(c->len && (err = svsend(c))) break;
+                if(c->len) break;                        // waits for EPOLLOUT
+                ssize_t nr = read(c->fd, c->hdr + c->nhdr, 4 - c->nhdr);
+                if(nr < 0 && errno == EINTR) continue;
+                if(nr < 0 && errno == EAGAIN) break;
+                if(nr < 1) { err = 1; break; }
+                if((c->nhdr += nr) < 4) continue;
+                uint32_t len; memcpy(&len, c->hdr, 4);
+                c->nhdr = 0;
+                if(len > SV_MAXREQ) { err = 1; break; }  // protocol error
+                if(!len) continue;
+                c->rqt = get_nanos();
+                if(pl.head - pl.tail < len) c->nmiss++;
+                while(pl.head - pl.tail < len)
+                    if(svfill(&pl)) return hltfail(djb2tum_health(ctx));
+                svtake(&pl, c->out, len);
+                c->len = len; c->nreq++; c->nbytes += len;
+            }
+            if(err) {
+                nbytes += c->nbytes; nmiss += c->nmiss; nreq += c->nreq;
+                svclose(ep, c, quiet);
+            }
+        }
+        // the urgent refill, below the low watermark, does not wait for idle
+        for(uint32_t b = (ne > 0 && lvl >= SV_LOW) ? 0 : SV_FILL; b; b--) {
+            if(pl.head - pl.tail >= SV_POOL - BLOCK_SIZE) break;
+            if(svfill(&pl)) return hltfail(djb2tum_health(ctx));
+        }
+    }
+
+    for(uint32_t i = 0; i < SV_MAXC; i++) if(cl[i].fd >= 0) {
+        nbytes += cl[i].nbytes; nmiss += cl[i].nmiss; nreq += cl[i].nreq;
+        svclose(ep, &cl[i], quiet);
+    }
+    close(ls); close(ep); unlink(path);
+    if(quiet < 2)
+        perr("\nServer: %.0lf clients, %.0lf requests, %.0lf bytes, %.0lf misses, "
+            "hashed %.3lfMB in %.3lfs\n\n", (df)ncl, (df)nreq, (df)nbytes,
+            (df)nmiss, (df)pl.head / (1 << 20), (df)(get_nanos() - st) / E9);
+    return 0;
+}
+
+/** EXPANSION *****************************************************************/
+/*
+ * With -X the output is the keystream of a ChaCha20 (RFC 8439) keyed by the
+ * uChaos output: a raw block is hashed, XOR-folded into 32 bytes of key and
+ * 12 of nonce, and the key is mixed with a block of the previous keystream
+ * (fast key erasure) every -X KB of output or -x ms. Between reseeds the rate
+ * is the one of the cipher, without the yields. The raw output is the default
+ * and the only one for -k: the expanded one adds no entropy, it spreads it.
+ * -X is bounded by CC20_MAXKB, thus a reseed always comes before the 32-bit
+ * block counter wraps, and the next key is from a block that is never output.
+ */
+
+#define CC20_MAXKB (1U << 27)        // 128GB, half of the counter range
+
+typedef struct {
+    uint32_t key[8], nnc[3], ctr;
+    uint64_t nout, osd, tsd, nsd;    // bytes out, at the last reseed, its ns
+} cc20_t;
+
+#define CC20_QR(a,b,c,d) \
+    a += b; d ^= a; d = (d << 16) | (d >> 16); \
+    c += d; b ^= c; b = (b << 12) | (b >> 20); \
+    a += b; d ^= a; d = (d <<  8) | (d >> 24); \
+    c += d; b ^= c; b = (b <<  7) | (b >> 25);
+
+static void cc20blk(const uint32_t *key, const uint32_t *nnc, uint32_t ctr,
+    uint32_t *out)
+{
+    uint32_t x[16] = { 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+        key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+        ctr, nnc[0], nnc[1], nnc[2] }, i[16];
+    memcpy(i, x, sizeof(x));
+    for(uint32_t r = 0; r < 10; r++) {
+        CC20_QR(x[0], x[4], x[ 8], x[12]) CC20_QR(x[1], x[5], x[ 9], x[13])
+        CC20_QR(x[2], x[6], x[10], x[14]) CC20_QR(x[3], x[7], x[11], x[15])
+        CC20_QR(x[0], x[5], x[10], x[15]) CC20_QR(x[1], x[6], x[11], x[12])
+        CC20_QR(x[2], x[7], x[ 8], x[13]) CC20_QR(x[3], x[4], x[ 9], x[14])
+    }
+    for(uint32_t k = 0; k < 16; k++) out[k] = x[k] + i[k];
+}
+
+static void cc20seed(cc20_t *c, const uint8_t *raw, uint32_t sz) {
+    uint32_t x[11] = { 0 }, o[16];
+    for(uint32_t a = 0; a < sz; a++) ((uint8_t *)x)[a % sizeof(x)] ^= raw[a];
+    cc20blk(c->key, c->nnc, c->ctr, o);          // the old key is forgotten
+    for(uint32_t k = 0; k < 8; k++) c->key[k] = o[k] ^ x[k];
+    for(uint32_t k = 0; k < 3; k++) c->nnc[k] = x[8 + k];
+    c->ctr = 0; c->osd = c->nout; c->tsd = get_nanos(); c->nsd++;
+}
+
+static void cc20fill(cc20_t *c, uint8_t *dst, uint32_t len) {
+    uint32_t o[16];
+    for(uint32_t a = 0; a < len; a += sizeof(o)) {
+        cc20blk(c->key, c->nnc, c->ctr++, o);
+        memcpy(dst + a, o, MIN(sizeof(o), len - a));
+    }
+    c->nout += len;
+}
+
+static inline bool cc20due(cc20_t *c, uint32_t xkb, uint32_t xms) {
+    return !c->nsd || c->nout - c->osd >= ((uint64_t)xkb << 10)
+        || (xms && get_nanos() - c->tsd >= (uint64_t)xms * E6);
+}
+
+// r raw bytes hashed in t ns, the keystream out of the whole run in e ns
+#define perrxpn(c,r,t,e) perr("Expand: raw %.3lg MB/s, %.3lfMB by %.0lf "\
+    "reseeds; out %.3lg MB/s, %.3lfMB by chacha20\n\n", (df)(r) * E3 / MAX(t, 1),\
+    (df)(r) / (1 << 20), (df)(c).nsd, (df)(c).nout * E3 / MAX(e, 1),\
+    (df)(c).nout / (1 << 20))
+
+/** STATE *********************************************************************/
+/*
+ * With --state FILE the warm context is loaded at the start, thus the dry runs
+ * are skipped, and saved at the exit, also by SIGINT or SIGTERM which stop the
+ * run as its end. A missing or a foreign file is a cold start, as without it.
+ */
+
+static djb2_t *stctx = NULL;
+static const char *stpath = NULL;
+static uint8_t stnbtls = 0;
+
+static void stsave(void) {
+    if(!stctx || djb2tum_health(stctx)) return;     // a failed one is not kept
+    if(djb2tum_save(stctx, stpath, stnbtls)) perror("state save");
+}
+
+/** BOOT **********************************************************************/
+/*
+ * With -B the run is a boot profile for -k: the memory is locked, thus each
+ * page is faulted once at its mapping and not in the hot loop, and the first
+ * blocks after the input go to the kernel before the dry runs, until BT_EARLY
+ * bits are credited. While the min-entropy estimate is warming up they are
+ * credited at BT_FLOOR bits for each sample, not by the entropy() policy which
+ * is optimistic for a cold context. The normal run then refines the pool.
+ * The phases are by CLOCK_BOOTTIME and the crng is ready when a non-blocking
+ * getrandom works: the report has them in ms since the exec, known by 1/HZ
+ * from /proc.
+ */
+
+#define BT_EARLY 256                 // bits credited before the dry runs
+#define BT_MAXB   16                 // max blocks for them, on a cold context
+#define BT_FLOOR   1                 // bits by sample, until djb2tum_hmin()
+#ifndef GRND_NONBLOCK
+#define GRND_NONBLOCK 0x1
+#endif
+
+enum { BT_EXEC, BT_MAIN, BT_READ, BT_FRST, BT_CRDT, BT_DRY, BT_PROD, BT_CRNG,
+    BT_DONE, BT_NPH };
+static const char *btnm[BT_NPH] = { "exec", "main", "read", "1st credit",
+    "256b", "dry runs", "production", "crng ready", "exit" };
+static uint64_t btph[BT_NPH];
+static uint8_t btquiet;
+
+static inline void btmark(uint32_t p) {
+    if(!btph[p]) btph[p] = getclkns(CLOCK_BOOTTIME);
+}
+
+static inline bool crngready(void) {
+    uint8_t b;
+    return syscall(SYS_getrandom, &b, 1, GRND_NONBLOCK) == 1;
+}
+
+// the process start time since boot, from the field 22 of /proc/self/stat
+static uint64_t btexec(void) {
+    char buf[512], *p;
+    unsigned long long st = 0;
+    int fd = open("/proc/self/stat", O_RDONLY);
+    if(fd < 0) return 0;
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if(n <= 0) return 0;
+    buf[n] = 0;
+    if(!(p = strrchr(buf, ')'))) return 0;  // the comm can have spaces
+    if(sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u "
+        "%*d %*d %*d %*d %*d %*d %llu", &st) != 1) return 0;
+    return st * E9 / sysconf(_SC_CLK_TCK);
+}
+
+static void btreport(void) {
+    btmark(BT_DONE);
+    if(btquiet > 1) return;
+    uint64_t t0 = MIN(btph[BT_EXEC], btph[BT_MAIN]);
+    perr("Boot:");
+    for(uint32_t p = BT_MAIN; p < BT_NPH; p++) if(btph[p])
+        perr(" %s %.1lf%s", btnm[p], (df)(btph[p] - t0) / E6,
+            (p + 1 < BT_NPH) ? "," : "");
+    perr(" ms since exec, %.1lf ms since boot\n\n", (df)btph[BT_DONE] / E6);
+}
+
+#define perrdgst(d,b) perr("Replay: digest %016llx over %.0lf bytes, %s, %u-bit words\n\n",\
+    (unsigned long long)(d), (df)(b), djb2tum_variant(), ABN)
+
+#define perrprms(s,p) perr("%s s:%u, q:%u, d+p(%u):%u+%u %s, r:%u, i:%u, Z:%u, j:%u, l:%u\n\n",\
+              s, nbtls, quiet, pmdly, nsdly, p?p:1, clkunit(), nrdry, nblks, rset, nthrd, nlns)
 
 int main(int argc, char *argv[]) {
-    struct rand_pool_info_buf entrnd;
-    uint8_t *str = NULL, nbtls = 0, prsts = 0, quiet = 0, rset = 0;
-    uint32_t ntsts = 1, nsdly = 0, nrdry = 1, nblks = 1, pmdly = 0;
+    uint8_t *str = NULL, nbtls = 0, prsts = 0, quiet = 0, rset = 0, nlns = 1;
+    uint8_t bprbs = 0, vrsn = 0, cndtn = 0, entt = 0, ecap = 7, hist = 0;
+    uint8_t feed = 0, boot = 0;
+    const char *clknm = NULL, *cfile = NULL, *rfile = NULL, *hfile = NULL;
+    const char *sfile = NULL, *tfile = NULL;
+    uint32_t ntsts = 1, nsdly = 0, nrdry = 1, nblks = 1, pmdly = 0, nthrd = 0;
+    uint32_t dupmb = 0, atms = 0, fdms = 0, xkb = 0, xms = 0;
     int devfd = 0;
+    static djb2_t ctx;               // static, for the save at the exit
+    worker_t *wrk = NULL;
 
     // Collect arguments from optional command line parameters
     while (1) {
-        int opt = getopt(argc, argv, "hvSZG:M:K:T:s:d:p:r:k:i:q");
+        int opt = getopt_long(argc, argv, "hvBSZCEG:M:K:T:s:d:p:r:k:i:j:l:m:e:A:f:X:x:P:c:q",
+                              lopts, NULL);
         if(opt == 'S' || opt == 'Z') {
             nsdly = 3; nblks = 16; nrdry = 31; ntsts = 8;
             rset = (opt == 'Z') ? 19 : 0;
             perrwrn();
         } else
         if(opt == 'v') {
-            perr_app_info(2);
-            return 0;
+            vrsn = 1;
+        } else
+        if(opt == 'B') {
+            boot = 1;
         } else
         if(opt == 'q') {
             quiet = (++quiet) ? quiet : 2;
         } else
+        if(opt == OPT_BPRB) {
+            bprbs = 1;
+        } else
+        if(opt == OPT_CAPT) {
+            cfile = optarg;
+        } else
+        if(opt == OPT_RPLY) {
+            rfile = optarg;
+        } else
+        if(opt == OPT_HIST) {
+            hist = 1; hfile = optarg;
+        } else
+        if(opt == OPT_SERV) {
+            sfile = optarg;
+        } else
+        if(opt == OPT_STAT) {
+            tfile = optarg;
+        } else
+        if(opt == 'C') {
+            cndtn = 1;
+        } else
+        if(opt == 'E') {
+            entt = 1;
+        } else
         if(opt == '?' || opt == 'h') {
             char *p, *q = argv[0];
             if(q) for(p = q; *p; p++) if(*p == '/') q = p+1;
@@ -838,6 +3053,19 @@ int main(int argc, char *argv[]) {
             case 'r': nrdry = ABS(x); break;
             case 'p': pmdly = ABS(x); break;
             case 'i': nblks = ABS(x); break;
+            case 'j': nthrd = MIN(ABS(x), MAX_THRDS); break;
+            case 'l': nlns  = MAX(1, MIN(ABS(x), LNMAX)); break;
+            case 'm': dupmb = ABS(x); break;
+            case 'e': ecap  = MIN(ABS(x), 8); break;
+            case 'A': atms  = MAX(1, ABS(x)); break;
+            case 'f': fdms  = ABS(x); feed = 1; break;
+            case 'X': xkb   = MAX(1, MIN(ABS(x), CC20_MAXKB)); break;
+            case 'x': xms   = ABS(x); break;
+            case 'c': clknm = optarg; break;
+            case 'P':
+                if(!djb2tum_probe(optarg)) break;
+                perr("\nERROR: "APPNAME" unknown or unavailable probe %s\n\n", optarg);
+                return EXIT_FAILURE;
             case 'k': devfd = open(optarg,O_WRONLY); break;
             case 'G': ntsts = ABS(x); ntsts <<= 21 ; prsts = 1; break;
             case 'M': ntsts = ABS(x); ntsts <<= 11 ; prsts = 1; break;
@@ -850,10 +3078,78 @@ int main(int argc, char *argv[]) {
         perror("open device");
         return EXIT_FAILURE;
     }
+    if (djb2tum_clock(clknm ? clknm : CLK_DEFAULT)
+    && (clknm || djb2tum_clock("auto"))) {
+        perr("\nERROR: "APPNAME" unknown or unavailable clock %s\n\n", clknm);
+        return EXIT_FAILURE;
+    }
+    if(vrsn) {
+        perr_app_info(2);
+        return 0;
+    }
+    if(bprbs && rfile) {
+        perr("\nERROR: "APPNAME" --bench-probes measures the host, not a replay\n\n");
+        return EXIT_FAILURE;
+    }
+    if(rfile && (devfd || feed || sfile || boot)) {
+        // a replay is deterministic: no entropy to credit nor to serve
+        perr("\nERROR: "APPNAME" --replay is for tests, not with -k -f -B --serve\n\n");
+        return EXIT_FAILURE;
+    }
+#ifdef _USE_PROFILING
+    atexit(prf_report);
+#endif
+    if(boot) {
+        btph[BT_EXEC] = btexec(); btmark(BT_MAIN); btquiet = quiet;
+        if(crngready()) btmark(BT_CRNG);        // the kernel did not wait
+        if(mlockall(MCL_CURRENT | MCL_FUTURE)) perror("mlockall");
+        atexit(btreport);
+    }
+    if(rfile && djb2tum_replay(rfile)) {
+        perror("replay");
+        return EXIT_FAILURE;
+    }
+    if(rfile) nthrd = 0;             // a single stream, a single sequence
+    if(feed && !devfd) {
+        perr("\nERROR: "APPNAME" option -f feeds the device of -k only\n\n");
+        return EXIT_FAILURE;
+    }
+    if(xkb && devfd) {
+        perr("\nERROR: "APPNAME" option -X output is not for -k, raw only\n\n");
+        return EXIT_FAILURE;
+    }
+    if(feed || sfile || xkb) nthrd = 0;   // on demand, a block at a time
+    if(rfile) tfile = NULL;          // the replay is from the cold state
+    if(tfile) nthrd = 0;             // the main context is the saved one
+    if(cfile && djb2tum_capture(cfile, CAP_NBITS)) {
+        perror("capture");
+        return EXIT_FAILURE;
+    }
     if(quiet) prsts = 0;
 
     // Counting time of running starts here, after parameters
     (void) get_nanos();
+    if(bprbs) {
+        bench_probes(nbtls);
+        return 0;
+    }
+    djb2tum_init(&ctx);
+    ctx.nlns = nlns;
+    if(hist && !(ctx.hdr = calloc(1, sizeof(djb2hdr_t)))) {
+        perror("calloc");
+        return EXIT_FAILURE;
+    }
+    if(tfile) {
+        if(!djb2tum_load(&ctx, tfile, nbtls)) nrdry = 0;   // already warm
+        else if(errno != ENOENT) perror("state load");
+        struct sigaction sa = { .sa_handler = fdsignal };
+        sigaction(SIGINT, &sa, NULL);
+        sigaction(SIGTERM, &sa, NULL);
+        stctx = &ctx; stpath = tfile; stnbtls = nbtls;
+        atexit(stsave);
+    }
+    if(cndtn)
+        return conditioner(&ctx, devfd, nrdry, nsdly, pmdly, nbtls, quiet, ecap);
 
     if (posix_memalign((void **)&str, ALGN, BLOCK_SIZE + ABz+1) || !str) {
         perror("posix_memalign");
@@ -865,17 +3161,74 @@ int main(int argc, char *argv[]) {
     if(n < 1) return EXIT_FAILURE;     // djb2tum(9 code refactored thus not anymore
     //if (nblks > 1) bin2str(str, n); // necessary because djb2tum() born for text,
     str[n] = 0;                      // refactoring it for binary input, is the way.
+    if(boot) btmark(BT_READ);
+
+    if(atms && autotune(str, n, atms, &nbtls, &nsdly, &pmdly, &nrdry, quiet))
+        return EXIT_FAILURE;
+    stnbtls = nbtls;                 // the state is saved in the tuned units
 
     archul_t *hsh = NULL;
+    uint64_t btcrd = 0, btcrb = 0;
+    for(uint32_t k = 0; boot && devfd && btcrd < BT_EARLY && k < BT_MAXB; k++) {
+        uint32_t size = n;           // the early credits, by a cold context
+        uint64_t ctot = ctx.ctot;
+        hsh = str2hsh(&ctx, str, hsh, &size, nsdly, pmdly, nbtls, 0);
+        if(!hsh) return EXIT_FAILURE;
+        if(djb2tum_health(&ctx)) return hltfail(djb2tum_health(&ctx));
+        uint64_t nsmp = ctx.ctot - ctot;
+        uint32_t crd = djb2tum_hmin(&ctx) ? djb2credit(&ctx, nsmp, size << ABL, ecap)
+            : MIN(nsmp * BT_FLOOR, (uint64_t)ecap * (size << ABL));
+        if(rndaddentropy(devfd, (uint8_t *)hsh, size << ABL, crd))
+            return EXIT_FAILURE;
+        btmark(BT_FRST); btcrd += crd; btcrb += size << ABL;
+        if(crngready()) btmark(BT_CRNG);
+    }
+    if(btcrd >= BT_EARLY) btmark(BT_CRDT);
+    if(nthrd) {
+        // the workers do their own preliminary runs in parallel
+        if (posix_memalign((void **)&hsh, ALGN, BLOCK_SIZE) || !hsh
+        ||  posix_memalign((void **)&wrk, ALGN, nthrd * sizeof(*wrk)) || !wrk) {
+            perror("posix_memalign");
+            return EXIT_FAILURE;
+        }
+        memset(wrk, 0, nthrd * sizeof(*wrk));
+        for(uint32_t t = 0; t < nthrd; t++) {
+            worker_t *w = &wrk[t];
+            if (posix_memalign((void **)&w->rng, ALGN, sizeof(ring_t)) || !w->rng) {
+                perror("posix_memalign");
+                return EXIT_FAILURE;
+            }
+            memset(w->rng, 0, sizeof(ring_t));
+            w->str = str; w->n = n; w->idx = t; w->cpu = getcpuidx(t);
+            w->nblk = ntsts / nthrd + (t < ntsts % nthrd);
+            w->nrdry = nrdry; w->nsdly = nsdly; w->pmdly = pmdly;
+            w->nbtls = nbtls; w->rset = rset; w->nlns = nlns; w->ecap = ecap;
+            if(hist && !(w->hdr = calloc(1, sizeof(djb2hdr_t)))) {
+                perror("calloc");
+                return EXIT_FAILURE;
+            }
+            errno = pthread_create(&w->tid, NULL, worker, w);
+            if(errno) {
+                perror("pthread_create");
+                return EXIT_FAILURE;
+            }
+        }
+    } else
     for(uint32_t a = nrdry; a; a--) {
         uint32_t size = n;
-        hsh = str2hsh(str, hsh, &size, nsdly, pmdly, nbtls, 0);
+        hsh = str2hsh(&ctx, str, hsh, &size, nsdly, pmdly, nbtls, 0);
         if(!hsh) return EXIT_FAILURE;
     }
+    if(boot) btmark(BT_DRY);
+    if(feed)
+        return feeder(&ctx, str, n, devfd, nsdly, pmdly, nbtls, quiet, ecap, fdms);
+    if(sfile)
+        return server(&ctx, str, n, sfile, nsdly, pmdly, nbtls, quiet);
 
-    archul_t max   = 0,   min = E9;
-    uint64_t bic   = 0,   avg = 0, nk = 0, nt = 0, nx = 0, nn = 0, mt = 0;
-    df       avgbc = 0, avgmx = 0, avgmn = 256;
+    uint64_t nt = 0, mt = 0, ncrd = btcrd, ncrb = btcrb;
+    uint64_t dgst = HSHSEED, ndgb = 0, nraw = 0;
+    cc20_t   xpn = { { 0 }, { 0 }, 0, 0, 0, 0, 0 };
+    anlz_t   an;
 
     if(quiet < 2) {
         perr_app_info(0);
@@ -887,79 +3240,100 @@ int main(int argc, char *argv[]) {
         } else perrprms("", 0);
     }
 
-    for (uint32_t a = ntsts; a; a--) {
+    outbuf_t ob;
+    if(outbuf_init(&ob, STDOUT_FILENO)) return EXIT_FAILURE;
+    if(prsts && ntsts > 1 && anlz_start(&an, nlns, dupmb, entt)) return EXIT_FAILURE;
+
+    for (uint32_t a = ntsts; a && !fdstop; a--) {
         // hashing
         uint32_t size = n;
         uint64_t stns = get_nanos(); /**** hashing time accounting start ******/
-        hsh = str2hsh(str, hsh, &size, nsdly, pmdly, nbtls, rset);
+        uint32_t hfl, crd;
+        if(nthrd) {
+            // round-robin merge, deterministic order by the block index
+            worker_t *w = &wrk[(ntsts - a) % nthrd];
+            memcpy(hsh, ring_rget(w->rng, &size)->dt, BLOCK_SIZE);
+            hfl = size ? 0 : djb2tum_health(&w->ctx);
+            crd = ring_rcrd(w->rng);
+            ring_rput(w->rng);
+        } else
+        if(xkb && !cc20due(&xpn, xkb, xms)) {
+            size = (n + ABz) >> ABL; // the keystream only, below
+            hfl = crd = 0;
+        } else {
+            uint64_t ctot = ctx.ctot;
+            hsh = str2hsh(&ctx, str, hsh, &size, nsdly, pmdly, nbtls, rset);
+            hfl = djb2tum_health(&ctx);
+            crd = djb2credit(&ctx, ctx.ctot - ctot, size << ABL, ecap);
+            if(xkb && hsh) {
+                cc20seed(&xpn, (uint8_t *)hsh, size << ABL);
+                nraw += size << ABL;
+            }
+        }
         mt += get_nanos() - stns; /******* hashing time accounting stop *******/
         if(!hsh) return EXIT_FAILURE;
+        if(hfl) { outbuf_flush(&ob); return hltfail(hfl); }
+        if(xkb) cc20fill(&xpn, (uint8_t *)hsh, size << ABL);
 
         uint32_t sz = size << ABL;
+        if(rfile) { dgst = fnv1a64(dgst, (uint8_t *)hsh, sz); ndgb += sz; }
         if(devfd) {
-            entrnd.buf_size = sz;
-            entrnd.entropy_count = entropy(sz);
-            memcpy((uint8_t *)entrnd.buf, (uint8_t *)hsh, sz);
-            #define OPTNK "option -k is designed for /dev/[u]random only"
-            if (ioctl(devfd, RNDADDENTROPY, &entrnd) < 0 && errno != EINTR) {
-                if(errno == ENOTTY) {
-                  perr("\nERROR: "APPNAME" "OPTNK"\n\n");
-                } else perror("ioctl entrnd");
+            if(rndaddentropy(devfd, (uint8_t *)hsh, sz, crd))
                 return EXIT_FAILURE;
-            }
+            ncrd += crd; ncrb += sz;
+            if(boot) btmark(BT_PROD);
+            if(boot && !btph[BT_CRNG] && crngready()) btmark(BT_CRNG);
             if (quiet < 2) // avoid the need of >/dev/null
-                writebuf(STDOUT_FILENO, (uint8_t *)hsh, sz);
+                outbuf_put(&ob, (uint8_t *)hsh, sz);
         } else {
-                writebuf(STDOUT_FILENO, (uint8_t *)hsh, sz);
+                outbuf_put(&ob, (uint8_t *)hsh, sz);
         }
 
         // single run
-        if(ntsts < 2) return 0;
+        if(ntsts < 2 && !hist) { outbuf_flush(&ob); return 0; }
 
         // skip stats
         if(!prsts) continue;
 
-        // self-evaluation of the output including the check for repetitions
-        avg = 0, nn = 0;
-        for (uint32_t n = 0; n < size; n++) {
-            for (uint32_t i = n + 1; i < size; i++) {
-                if (hsh[i] == hsh[n]) {
-                    perr("%d:%d ", n, i);
-                    nk++; continue;
-                }
-                archul_t cb = hsh[i] ^ hsh[n];
-                int ham = 0;
-                for (int a = 0; a < ABN; a++)
-                    ham += (cb >> a) & 0x01;
-                bic += ham;
-                avg += ham;
-                if(max < ham) max = ham;
-                if(min > ham) min = ham;
-                nx++;
-                nn++;
-            }
-        }
-
-        df curavg = (df)avg / nn;
-        if(avgmx < curavg) avgmx = curavg;
-        if(avgmn > curavg) avgmn = curavg;
-        avgbc += curavg;
+        // self-evaluation of the output, by the analyser thread
+        anlz_push(&an, hsh, size);
         nt += size;
-
-        //sched_yield();// Statistics are a block of CPU data-crunching but also
-                        // a predictable delay which sched_yield() can jeopardise.
-                        // Stats makes the large size output slower 1.7x than -q.
     }
 
+    outbuf_flush(&ob);
     uint64_t rt = get_nanos();
     free(hsh); hsh = NULL;
-    if(!prsts) return 0;
+    if(!prsts) {
+        // the workers are done with all the blocks read, joined before any
+        // of their contexts is read by the report
+        for(uint32_t t = 0; t < nthrd; t++) {
+            pthread_join(wrk[t].tid, NULL);
+            if(hist) djb2tum_merge(&ctx, &wrk[t].ctx);
+        }
+        if(devfd && quiet < 2)
+            perrcrd(ncrd, ncrb, nthrd ? &wrk[0].ctx : &ctx);
+        if(rfile && quiet < 2) perrdgst(dgst, ndgb);
+        if(xkb && quiet < 2) perrxpn(xpn, nraw, mt, rt);
+        if(hist && quiet < 2) { hdr_report(ctx.hdr); perr("\n"); }
+        return (hfile && hdr_csv(ctx.hdr, hfile)) ? EXIT_FAILURE : 0;
+    }
 
+    anlz_stop(&an);
+    uint64_t nk = an.nk;
     perr("%s\n", nk ? ", status: KO" : "no, status: OK");
 
     // print statistics ////////////////////////////////////////////////////////
 
-    djb2_t *s = (djb2_t *)(uintptr_t)djb2tum(DJB2VGET, 0, 0, pmdly, 0, 0);
+    // with -j the main thread times only the rings: the hashing time is the
+    // wall-clock one of the workers together, from the first start to the end
+    uint64_t wst = -1, wet = 0;
+    for(uint32_t t = 0; t < nthrd; t++) {
+        pthread_join(wrk[t].tid, NULL);
+        djb2tum_merge(&ctx, &wrk[t].ctx);
+        wst = MIN(wst, wrk[t].st); wet = MAX(wet, wrk[t].et);
+    }
+    if(nthrd) mt = wet - wst;
+    djb2_t *s = djb2tum_stats(&ctx, pmdly);
     perrprms("Setting:", (uint32_t)(s ? s->pmns : 0));
 
     perr("Hashing: %u, ", ntsts);
@@ -971,8 +3345,7 @@ int main(int argc, char *argv[]) {
 
     if(nblks < 2) goto skiphamming;
 
-    avgbc /= ntsts;
-    df bic_nx_absl = (df)bic / nx;
+    df bic_nx_absl = (df)an.bic / an.nx;
     df bic_nx = (df)100 / ABN * bic_nx_absl;
 
     #define devppm(v,a) ( ((df)v-a) * E6 / a )
@@ -980,14 +3353,35 @@ int main(int argc, char *argv[]) {
     perr("Hamming <weight>: %.4lf%% ~ 50%% by (%+.4lg ppm)\n",
         bic_nx, devppm(bic_nx, 50));
     perr("Hamming distance: %.0lf <%.6lf> %.0lf over %.4lgK XORs\n",
-        (df)min, bic_nx_absl, (df)max, (df)nx/E3);
+        (df)an.min, bic_nx_absl, (df)an.max, (df)an.nx/E3);
+    if(nlns > 1) {
+        perr("Hamming lane <w>:");
+        for(uint8_t k = 0; k < nlns; k++)
+            perr(" %.3lf%%", (df)100 / ABN * an.lnbc[k] / MAX(an.lnwc[k], 1));
+        perr(" by %u lanes\n", nlns);
+    }
     perr("Hamming dist/avg: %.4lf < 1U:%u %+.4lg ppm > %.4lf\n\n",
-        avgmn/bic_nx_absl, ABN, devppm(bic_nx_absl, 32), avgmx/bic_nx_absl);
+        an.avgmn/bic_nx_absl, ABN, devppm(bic_nx_absl, 32), an.avgmx/bic_nx_absl);
 
 skiphamming:
-    perr("Perform: exec %.3lgs, %.3lg MB/s; hash %.3lgs, %.01lf KH/s\n",
-        (df)rt/E9, (df)(E9>>(20-ABL))*nt/rt, (df)mt/E9, (df)(E9>>10)*nt/mt);
+    if(an.eb) {
+        entr_t e;
+        entres(an.eb, &e);
+        perr("Entropy: %.6lf bits/byte, chi² %.2lf (p %.2lf%%), "
+            "mean %.4lf ~ %.1lf\n", e.ent, e.chi, e.pchi * 100, e.mean, AVGV);
+        perr("`MCarlo: π %.9lf (%+.4lf%%), serial correlation %+.6lf\n\n",
+            e.pi, (e.pi - M_PI) * 100 / M_PI, e.scc);
+    }
+
+    perr("Perform: exec %.3lgs, %.3lg MB/s; hash %.3lgs, %.01lf KH/s%s; "
+        "out %.3lgs, %.3lg MB/s by %s\n",
+        (df)rt/E9, (df)(E9>>(20-ABL))*nt/rt, (df)mt/E9,
+        (df)(E9>>10) * (xkb ? nraw >> ABL : nt) / mt, nthrd ? " wall" : "",
+        (df)ob.ns/E9, (df)ob.nbytes * E3 / MAX(ob.ns, 1), obmode[ob.mode]);
+    if(xkb) perrxpn(xpn, nraw, mt, rt);
 
+    if(devfd) perrcrd(ncrd, ncrb, nthrd ? &wrk[0].ctx : &ctx);
+    if(rfile) perrdgst(dgst, ndgb);
     if(nblks < 2) goto skiptimings;
 
     df mean = (df)s->avg  / s->tncl;
@@ -995,19 +3389,243 @@ skiphamming:
 
     #define dk(a,b,c) ( (1.0 - (df)(a-b)/c) * E3 )
 
-    perr("Latency: %.0f <%.01lf> %.01lfK ns, %.3lgK w/ ev:%.0f, ex:%5.02lf%%\n",
-        (df)s->tdmn, mean, (df)s->tdmx/E3, (df)s->tncl/E3, (df)s->evnt,
+    perr("Latency: %.0f <%.01lf> %.01lfK %s, %.3lgK w/ ev:%.0f, ex:%5.02lf%%\n",
+        (df)s->tdmn, mean, (df)s->tdmx/E3, clkunit(), (df)s->tncl/E3, (df)s->evnt,
             ((df)s->nexp/s->ctot)*100);
     perr("`Ratios: %.02lf <avg=1U> %.02lf, min=1U <%.02lf> %.01lf, %.01fb\n",
         (df)s->tdmn/mean, (df)s->tdmx/mean, mean/s->tdmn, (df)s->tdmx/s->tdmn,
             __builtin_log2f(mean - s->tdmn));
-    perr("Jitters: %.0f <%.01lf> %.0f ns w/ %.03lgx, %.0lf:1K, %+.01lf‰\n",
-        (df)s->jmn, jean, (df)s->jmx, (df)s->jmx/jean, dk(s->ctot, s->tncl, s->ctot),
+    perr("Jitters: %.0f <%.01lf> %.0f %s w/ %.03lgx, %.0lf:1K, %+.01lf‰\n",
+        (df)s->jmn, jean, (df)s->jmx, clkunit(), (df)s->jmx/jean, dk(s->ctot, s->tncl, s->ctot),
             dk(mean, s->tdmn, jean));
 
 skiptimings:
+    if(hist) hdr_report(ctx.hdr);
+    if(hfile && hdr_csv(ctx.hdr, hfile)) return EXIT_FAILURE;
     perr("\n");
 
     return 0; // exit() do free()
 }
 
+#else /* _USE_TINY ************************************************************/
+
+/** TINY PROFILE **************************************************************/
+/*
+ * With -D_USE_TINY this main replaces the one above, for the 2MB RAM targets:
+ * the buffers are static arenas sized at the build time, there is no heap nor
+ * threads, stdio and libm are not linked, and the report is integer-only by
+ * write(2). It keeps the boot-time use, stdin to stdout or to the -k device,
+ * thus the options are a subset: -S -Z -q -v -k -e -d -p -s -r -i -c -P -T -K
+ * -M -G, with the same meaning of the full build.
+ */
+
+static uint8_t  tstr[BLOCK_SIZE + ABz+1] __attribute__((aligned(ALGN)));
+static archul_t thsh[BLOCK_SIZE >> ABL] __attribute__((aligned(ALGN)));
+static djb2_t   tctx;
+
+typedef struct { char b[256]; uint32_t n; } tline_t;
+
+static void tput(tline_t *l, const char *s) {
+    while(*s && l->n < sizeof(l->b)) l->b[l->n++] = *s++;
+}
+
+// v / 10^dec, with dec decimal digits
+static void tputu(tline_t *l, uint64_t v, uint8_t dec) {
+    char d[24];
+    uint32_t i = 0;
+    do { d[i++] = '0' + v % 10; if(i == dec) d[i++] = '.'; } while((v /= 10) || i <= dec + (dec > 0));
+    while(i && l->n < sizeof(l->b)) l->b[l->n++] = d[--i];
+}
+
+static void tflush(tline_t *l) {
+    (void)!write(STDERR_FILENO, l->b, l->n); l->n = 0;
+}
+
+static uint32_t tatou(const char *s) {
+    uint32_t x = 0;
+    if(*s == '-') s++;               // ABS, as the full build
+    while(*s >= '0' && *s <= '9') x = x * 10 + (*s++ - '0');
+    return x;
+}
+
+static void tusage(tline_t *l, const char *name) {
+    tput(l, "\n"APPNAME" "VERSION" tiny build, usage: [cat file |] ");
+    tput(l, name);
+    tput(l, " [-SZqv] [-k dev] [-e|d|p|s|r|i N] [-c clk] [-P prb] [-T|K|M|G N]\n"
+        " \\_ the options are the same of the full build, see its -h\n\n");
+    tflush(l);
+}
+
+static void tappinfo(tline_t *l) {
+    tput(l, APPNAME); tputu(l, ABN, 0); tput(l, " "VERSION" tiny ");
+    tput(l, djb2tum_clkname()); tput(l, " "); tput(l, djb2tum_variant());
+    tput(l, "\n"); tflush(l);
+}
+
+int main(int argc, char *argv[]) {
+    uint8_t nbtls = 0, prsts = 0, quiet = 0, rset = 0, vrsn = 0, ecap = 7;
+    const char *clknm = NULL;
+    uint32_t ntsts = 1, nsdly = 0, nrdry = 1, nblks = 1, pmdly = 0;
+    int devfd = 0;
+    tline_t l = { .n = 0 };
+
+    // the short options only, grouped as getopt does: -Sk /dev/random
+    for(int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if(a[0] != '-' || !a[1]) goto usage;
+        for(a++; *a; a++) {
+            char o = *a;
+            if(o == 'S' || o == 'Z') {
+                nsdly = 3; nblks = 16; nrdry = 31; ntsts = 8;
+                rset = (o == 'Z') ? 19 : 0;
+                continue;
+            }
+            if(o == 'q') { quiet = (++quiet) ? quiet : 2; continue; }
+            if(o == 'v') { vrsn = 1; continue; }
+            if(!strchr("kedpsricPTKMG", o)) goto usage;
+            const char *v = a[1] ? a + 1 : (i + 1 < argc) ? argv[++i] : NULL;
+            if(!v) goto usage;
+            uint32_t x = tatou(v);
+            switch (o) {
+                case 's': nbtls = x; break;
+                case 'd': nsdly = x; break;
+                case 'r': nrdry = x; break;
+                case 'p': pmdly = x; break;
+                case 'i': nblks = x; break;
+                case 'e': ecap  = MIN(x, 8); break;
+                case 'c': clknm = v; break;
+                case 'P':
+                    if(!djb2tum_probe(v)) break;
+                    tput(&l, "\nERROR: "APPNAME" unknown or unavailable probe ");
+                    tput(&l, v); tput(&l, "\n\n"); tflush(&l);
+                    return EXIT_FAILURE;
+                case 'k': devfd = open(v, O_WRONLY); break;
+                case 'G': ntsts = x; ntsts <<= 21 ; prsts = 1; break;
+                case 'M': ntsts = x; ntsts <<= 11 ; prsts = 1; break;
+                case 'K': ntsts = x; ntsts <<=  1 ; prsts = 1; break;
+                case 'T': ntsts = x; ntsts <<=  1 ; prsts = 1; break;
+            }
+            break;                   // the rest of argv[i] was the value
+        }
+    }
+
+    if (devfd < 0) {
+        perror("open device");
+        return EXIT_FAILURE;
+    }
+    if (djb2tum_clock(clknm ? clknm : CLK_DEFAULT)
+    && (clknm || djb2tum_clock("auto"))) {
+        tput(&l, "\nERROR: "APPNAME" unknown or unavailable clock ");
+        tput(&l, clknm ? clknm : CLK_DEFAULT); tput(&l, "\n\n"); tflush(&l);
+        return EXIT_FAILURE;
+    }
+    if(vrsn) {
+        tappinfo(&l);
+        return 0;
+    }
+    if(quiet) prsts = 0;
+
+    // Counting time of running starts here, after parameters
+    (void) get_nanos();
+    djb2tum_init(&tctx);
+
+    uint32_t n = (nblks < 2) ? readbuf(STDIN_FILENO, tstr, BLOCK_SIZE, 0) \
+                             : readblocks(STDIN_FILENO, tstr, &nblks);
+    if(n < 1) return EXIT_FAILURE;
+    tstr[n] = 0;
+
+    for(uint32_t a = nrdry; a; a--) {
+        uint32_t size = n;
+        if(!str2hsh(&tctx, tstr, thsh, &size, nsdly, pmdly, nbtls, 0))
+            return EXIT_FAILURE;
+    }
+    if(quiet < 2) { tput(&l, "\n"); tappinfo(&l); }
+
+    uint64_t nt = 0, mt = 0, ncrd = 0, ncrb = 0;
+    for (uint32_t a = ntsts; a; a--) {
+        uint32_t size = n;
+        uint64_t ctot = tctx.ctot;
+        uint64_t stns = get_nanos(); /**** hashing time accounting start ******/
+        str2hsh(&tctx, tstr, thsh, &size, nsdly, pmdly, nbtls, rset);
+        mt += get_nanos() - stns; /******* hashing time accounting stop *******/
+
+        // fail closed: the output and the crediting stop here
+        uint32_t hfl = djb2tum_health(&tctx), sz = size << ABL;
+        if(hfl) {
+            tput(&l, "\nERROR: "APPNAME" health test failed:");
+            if(hfl & HLT_RCT_DLT) tput(&l, " RCT dlt");
+            if(hfl & HLT_APT_DLT) tput(&l, " APT dlt");
+            if(hfl & HLT_RCT_DFF) tput(&l, " RCT dff");
+            if(hfl & HLT_APT_DFF) tput(&l, " APT dff");
+            tput(&l, ", output stopped\n\n"); tflush(&l);
+            return EXIT_FAILURE;
+        }
+        if(devfd) {
+            static struct rand_pool_info_buf entrnd;
+            entrnd.buf_size = sz;
+            entrnd.entropy_count = djb2credit(&tctx, tctx.ctot - ctot, sz, ecap);
+            memcpy((uint8_t *)entrnd.buf, thsh, sz);
+            if (ioctl(devfd, RNDADDENTROPY, &entrnd) < 0 && errno != EINTR) {
+                if(errno == ENOTTY) {
+                    tput(&l, "\nERROR: "APPNAME" "OPTNK"\n\n"); tflush(&l);
+                } else perror("ioctl entrnd");
+                return EXIT_FAILURE;
+            }
+            ncrd += entrnd.entropy_count; ncrb += sz;
+            if (quiet < 2) // avoid the need of >/dev/null
+                writebuf(STDOUT_FILENO, (uint8_t *)thsh, sz);
+        } else {
+                writebuf(STDOUT_FILENO, (uint8_t *)thsh, sz);
+        }
+        nt += size;
+    }
+    uint64_t rt = get_nanos();
+
+    // the integer-only report: us, KB/s, KH/s, and x1000 for the decimals
+    if(devfd && quiet < 2) {
+        tput(&l, "\nCredits: "); tputu(&l, ncrd * 1000 / MAX(ncrb, 1), 3);
+        tput(&l, " bits/byte over "); tputu(&l, ncrb, 0);
+        tput(&l, " bytes, min-entropy "); tputu(&l, djb2tum_hmin(&tctx) * 1000 >> 8, 3);
+        tput(&l, " bits/sample\n"); tflush(&l);
+    }
+    if(!prsts) return 0;
+
+    djb2_t *s = djb2tum_stats(&tctx, pmdly);
+    tput(&l, "\nHashing: "); tputu(&l, ntsts, 0);
+    tput(&l, ", "); tputu(&l, nt, 0);
+    tput(&l, " H ("); tputu(&l, nt << ABL, 0); tput(&l, " B)\n"); tflush(&l);
+
+    tput(&l, "Perform: exec "); tputu(&l, rt / E3, 0);
+    tput(&l, " us, "); tputu(&l, (nt << ABL) * E6 / MAX(rt, 1), 0);
+    tput(&l, " KB/s; hash "); tputu(&l, mt / E3, 0);
+    tput(&l, " us, "); tputu(&l, nt * E6 / MAX(mt, 1), 0);
+    tput(&l, " KH/s\n"); tflush(&l);
+
+    tput(&l, "Latency: "); tputu(&l, s->tdmn, 0);
+    tput(&l, " <"); tputu(&l, s->avg / MAX(s->tncl, 1), 0);
+    tput(&l, "> "); tputu(&l, s->tdmx, 0);
+    tput(&l, " "); tput(&l, clkunit()); tput(&l, " w/ ev:"); tputu(&l, s->evnt, 0);
+    tput(&l, ", ex:"); tputu(&l, s->nexp * 10000 / MAX(s->ctot, 1), 2);
+    tput(&l, "%\n"); tflush(&l);
+
+    tput(&l, "Jitters: "); tputu(&l, s->jmn, 0);
+    tput(&l, " <"); tputu(&l, s->javg / MAX(s->tncl, 1), 0);
+    tput(&l, "> "); tputu(&l, s->jmx, 0);
+    tput(&l, " "); tput(&l, clkunit()); tput(&l, ", min-entropy "); tputu(&l, djb2tum_hmin(&tctx) * 1000 >> 8, 3);
+    tput(&l, " bits/sample\n\n"); tflush(&l);
+
+    return 0;
+
+usage:
+    {
+        char *p, *q = argv[0];
+        if(q) for(p = q; *p; p++) if(*p == '/') q = p+1;
+        tusage(&l, q ? q : "uchaos");
+    }
+    return 0;
+}
+
+#endif /* _USE_TINY */
+
+#endif /* _UCHAOS_LIB */
+
@@ -0,0 +1,216 @@
+/*
+ * (c) 2026, Roberto A. Foglietta <roberto.foglietta@gmail.com>, GPLv2 license
+ *
+ * uChaos engine API: every generator is a caller-owned djb2_t context, thus
+ * one process can run as many independent generators as it needs (e.g. one
+ * per worker thread) without forking a uchaos binary for each one of them.
+ *
+ * Build the library: make libuchaos.a (or cc -c -D_UCHAOS_LIB uchaos.c)
+ * Link with:         cc app.c libuchaos.a (same -D_USE_* options of the lib)
+ *
+ *   djb2_t ctx;
+ *   djb2tum_init(&ctx);                            // cold initial state
+ *   h = str2hsh(&ctx, str, NULL, &size, 0, 0, 0, 0);   // fill words by str
+ *   djb2tum_stats(&ctx, 0)->tdmn;                  // timing stats up to now
+ *   djb2tum_rset(&ctx);                            // reset, keeps the totals
+ *
+ * A context is not thread-safe by itself: each thread owns its context.
+ */
+#ifndef _UCHAOS_H
+#define _UCHAOS_H
+
+#include <stdint.h>
+
+#ifdef _USE_FUNCS_32
+#define USE_FUNCS_32 1
+#else
+#define USE_FUNCS_32 0
+#endif
+
+// the word of the hashes, archul_t: 32, 64 or 128 bits by the build options
+#if USE_FUNCS_32
+    typedef float    archdf_t;
+    typedef uint32_t archul_t;
+#else
+    typedef double   archdf_t;
+    #if defined(__SIZEOF_INT128__)
+        #define HAS_UINT128 1
+        typedef unsigned __int128 uint128_t;
+        typedef uint128_t archul_t;
+    #else
+        #define HAS_UINT128 0
+        typedef uint64_t archul_t;
+    #endif
+
+#endif
+
+#define LNMAX 8          // max number of lanes fed by the same timing sample
+
+/*
+ * SP 800-90B health tests on the raw timing samples, as for a claimed min-
+ * entropy H = HLT_H bit per sample and a false alarm rate alpha = 2^-20: the
+ * repetition count cutoff is 1 + 20 / H, and the adaptive proportion cutoff
+ * of a non-binary source over a 512 samples window is 410 (90B, table 2).
+ * The cutoffs hold only for the claimed H, thus the credit is capped at HLT_H
+ * bits for each sample whatever djb2tum_hmin() measures: a higher claim would
+ * need tighter cutoffs (H = 6: RCT 5), which false alarm on the weak hosts.
+ */
+#define HLT_H      1     // min-entropy claimed, and credited at most, by sample
+#define HLT_RCTC  21     // repetition count test cutoff
+#define HLT_APTW 512     // adaptive proportion test window
+#define HLT_APTC 410     // adaptive proportion test cutoff
+
+#define HLT_RCT_DLT 0x1  // the bits of a tripped test, they are sticky
+#define HLT_APT_DLT 0x2
+#define HLT_RCT_DFF 0x4
+#define HLT_APT_DFF 0x8
+
+#define HMN_BINS   64    // dff 6 LSBs for the most common value estimate
+#define HMN_WARM 1024    // samples before the estimate is given
+#define HMN_WIN  8192    // samples in the window, older are halved out
+
+/*
+ * HDR-style log-linear histograms: the values below 2^HDR_SUBB have their own
+ * bucket, the others are split by their MSB position in 2^HDR_SUBB linear sub
+ * buckets, thus the relative error is within 1/2^HDR_SUBB at every scale.
+ */
+#define HDR_SUBB  4
+#define HDR_NBKT ( (64 - HDR_SUBB + 1) << HDR_SUBB )
+
+typedef struct {
+    uint64_t dlt[HDR_NBKT];         // raw latencies, in clock ticks
+    uint64_t dff[HDR_NBKT];         // their difference from the min
+    uint64_t rsc[HDR_NBKT];         // reschedules for each output word
+} djb2hdr_t;
+
+typedef struct {
+    uint64_t rv, av;                // RCT last value, APT reference value
+    uint32_t rc, ac, an;            // RCT run, APT count and window position
+} djb2hlt_t;
+
+typedef struct djb2tum_status {
+    uint64_t  ncl,  dmn,  dmx;
+    uint64_t tncl, tdmn, tdmx;
+    uint64_t ctot,  jmn,  jmx;
+    uint64_t evnt, nexp, javg;
+    uint64_t  avg,  oid, pmns, ohs;
+    uint64_t  ons;                  // previous time, it was a static in djb2tum
+    uint64_t nlns;                  // lanes: set 2..LNMAX after init, 1 is off
+    archul_t  lhs[LNMAX];           // lanes states, lhs[0] is unused (lane 0)
+    djb2hlt_t hlt[2];               // health tests state on the dlt and dff
+    uint32_t  hfl;                  // HLT_* bits of the tripped tests
+    uint32_t  mch[HMN_BINS];        // recent dff LSBs histogram, min-entropy
+    uint32_t  mcn;                  // samples since mch was last halved
+    djb2hdr_t *hdr;                 // histograms, NULL is off, caller's memory
+} __attribute__((aligned(8))) djb2_t;
+
+/*
+ * Raw timing capture file (djb2tum_capture): a 64 bytes header followed by a
+ * ring of nrec records of 32 bytes, all in host byte order. The writers take
+ * a slot by an atomic increment of head, which counts all the records ever
+ * written: the ring holds the last MIN(head, nrec) of them, the oldest one at
+ * head % nrec when head > nrec, else at 0. A sample that jumped to the
+ * reschedule without being hashed has CAP_RSCHD set in flags.
+ */
+#define CAP_MAGIC "uChaosCP"
+#define CAP_VERSION 1
+#define CAP_RSCHD   0x1
+
+typedef struct {
+    char     magic[8];              // CAP_MAGIC, not \0 terminated
+    uint32_t version, rsize;        // CAP_VERSION, sizeof(djb2rec_t)
+    uint64_t nrec;                  // records in the ring, a power of 2
+    uint64_t head;                  // records written, atomically incremented
+    uint32_t abn, tpus;             // word bits, clock ticks per us
+    char     clock[8];              // clock source name, \0 terminated
+    uint8_t  rsvd[16];
+} djb2caph_t;
+
+typedef struct {
+    uint64_t tm, dlt, dff;          // time >> -s, its delta, delta over dmn
+    uint32_t cpuid;                 // -1 when the clock does not report it
+    uint8_t  excp, flags;           // exception counter, CAP_* flags
+    uint16_t rsvd;
+} djb2rec_t;
+
+/*
+ * Warm state file (djb2tum_save): a 40 bytes header followed by the djb2_t of
+ * the same build, in host byte order; the checksum is FNV-1a over the djb2_t.
+ * The trackings are in the units of the clock and -s shift which made them,
+ * thus both are recorded and a load with others is refused.
+ */
+#define STT_MAGIC "uChaosST"
+#define STT_VERSION 2
+
+typedef struct {
+    char     magic[8];              // STT_MAGIC, not \0 terminated
+    uint32_t version, abn;          // STT_VERSION, word bits
+    uint32_t size;                  // sizeof(djb2_t)
+    uint8_t  nbtls, rsvd[3];        // -s shift of the timings
+    char     clock[8];              // clock source name, \0 terminated
+    uint64_t cksum;                 // FNV-1a 64 of the djb2_t that follows
+} djb2sth_t;
+
+/* *** ENGINE API *********************************************************** */
+
+// set the context in its cold initial state, as a fresh uchaos process has
+void      djb2tum_init(djb2_t *s);
+
+// accounts the current run in the totals and restarts the dmn/dmx tracking
+void      djb2tum_rset(djb2_t *s);
+
+// one hash by maxn jitter-driven rounds, the seed is xor-ed in the state
+archul_t  djb2tum_next(djb2_t *s, archul_t seed, uint8_t maxn, uint32_t nsdly,
+    uint32_t pmdly, uint8_t nbtls);
+
+// fill h (allocated when NULL) with a hash for each word of str[*size], with
+// nlns lanes the words come in groups of nlns for each djb2tum_next() call
+archul_t *str2hsh(djb2_t *s, const uint8_t *str, archul_t *h, uint32_t *size,
+    uint32_t nsdly, uint32_t pmdly, uint8_t nbtls, uint8_t rset);
+
+// 0 while the health tests pass, else the HLT_* bits: fail closed, the words
+// produced since the previous check should not be used nor credited
+uint32_t  djb2tum_health(const djb2_t *s);
+
+// min-entropy of the raw samples in 1/256 bit for each: the 90B most common
+// value estimate on the recent dff, bounded by log2 of the jitter range; it is
+// 0 until HMN_WARM samples, then the callers should use their fixed policy
+uint32_t  djb2tum_hmin(const djb2_t *s);
+
+// process-wide capture of the raw samples into the file at path, mmap'd with
+// 2^nbits records (the ring): no syscalls in the hot loop (-1: error, errno)
+int       djb2tum_capture(const char *path, uint8_t nbits);
+
+// process-wide replay of a capture file, or "synth" for a synthetic stream, as
+// the clock with the "none" probe: the same input gives the same output
+int       djb2tum_replay(const char *path);
+
+// saves the warm state of s, made with the nbtls shift on the current clock,
+// into path by a tmp file and a rename (-1: errno)
+int       djb2tum_save(const djb2_t *s, const char *path, uint8_t nbtls);
+
+// loads the warm part of a saved state into s, mixed with fresh timings, thus
+// the dry runs can be skipped (-1: errno, EINVAL for a bad or foreign file, or
+// one saved with another clock source or nbtls shift)
+int       djb2tum_load(djb2_t *s, const char *path, uint8_t nbtls);
+
+// value at the q quantile (0..1) of a HDR_NBKT histogram, as its bucket floor
+uint64_t  djb2hdr_quantile(const uint64_t *h, double q);
+
+// lower bound of the values counted in the bucket b
+uint64_t  djb2hdr_value(uint32_t b);
+
+// process-wide jitter probe: yield, sleep, pause, chase, futex, none (-1: unknown)
+int       djb2tum_probe(const char *name);
+
+// process-wide clock: auto, mono, mraw, boot, tsc, cntv (-1: unavailable)
+int       djb2tum_clock(const char *name);
+const char *djb2tum_clkname(void);
+
+// instruction set variant of the hot loop selected by CPUID, e.g. x86-64-v3
+const char *djb2tum_variant(void);
+
+// totals folded up to now, pmdly is the -p value used to compute the pmns
+djb2_t   *djb2tum_stats(djb2_t *s, uint32_t pmdly);
+
+#endif /* _UCHAOS_H */
@@ -1,8 +1,6 @@
 #!/bin/sh
 # (c) 2026, Roberto A. Foglietta <roberto.foglietta@gmail.com>, MIT license
 
-entgr() { ent "$@" | grep -E "error|samples|127.5 |Entropy|exceed|uncorrelated"; }
-
 nfle=${1:-test.txt}
 echo "uchaos.sh is appending to file: $nfle"
 
@@ -11,11 +9,11 @@ testfunc() {
     printf "\n|\/ Testing with $tcmd $fn _/\\__" | tee -a $nfle.$i
     {
         printf "_%.0s" {1..16}; printf "\n|\n";
-        cat $fn | { $tcmd 2>&3; printf "\n|\n" >&3; } | entgr
-    } 3>&1 | grep . >> $nfle.$i
+        cat $fn | $tcmd 2>&1 >/dev/null; printf "\n|\n";
+    } | grep . >> $nfle.$i
 }
 
-icmd="./uchaos -T $((${2:-96} * 1024))"
+icmd="./uchaos -E -T $((${2:-96} * 1024))"
 
 tcmd="$icmd    # default "
 i="n"; testfunc & sleep 0.01
@@ -13,7 +13,7 @@ fi
 fn="test"
 nh=$((512*1024))
 ch="./uchaos -i 16 -d 3 -T $nh"
-tf() { cat dmesg.txt | $ch | tee $1.dat | ent; }
+tf() { cat dmesg.txt | $ch -E > $1.dat; }
 
 for i in $(seq 32); do
 